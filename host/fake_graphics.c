@@ -0,0 +1,626 @@
+// Bitmaps, fonts and a software renderer into a frame buffer laid out as
+// the platform's: 1 bit per pixel on aplite, 1 byte on basalt and 1 byte
+// within the visible span of every row on chalk. Text comes from a built-in
+// 5x8 font scaled to the requested height, close enough for layout and goldens.
+#include <math.h>
+#include "host.h"
+
+struct GBitmap {
+  uint8_t *data;
+  uint16_t row_size;
+  GBitmapFormat format;
+  GRect bounds;
+  GColor *palette;
+  bool owns_data;
+  bool owns_palette;
+  int heap_bytes;
+};
+
+struct HostFont {
+  int height;
+  bool is_custom;
+};
+
+struct GContext {
+  GPoint origin;
+  GRect clip;
+  GColor stroke_color;
+  GColor fill_color;
+  GColor text_color;
+  GCompOp mode;
+};
+
+static GContext context;
+
+#ifdef PBL_COLOR
+#define FRAME_FORMAT PBL_IF_ROUND_ELSE(GBitmapFormat8BitCircular, GBitmapFormat8Bit)
+#define FRAME_ROW_SIZE HOST_SCREEN_WIDTH
+#else
+#define FRAME_FORMAT GBitmapFormat1Bit
+#define FRAME_ROW_SIZE ((HOST_SCREEN_WIDTH + 31) / 32 * 4)
+#endif
+
+static uint8_t frame_data[HOST_SCREEN_HEIGHT * FRAME_ROW_SIZE];
+static GBitmap frame = {
+  .data = frame_data,
+  .row_size = FRAME_ROW_SIZE,
+  .format = FRAME_FORMAT,
+  .bounds = { { 0, 0 }, { HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT } }
+};
+
+// Cost of the frame last drawn, from host_graphics_frame_begin() on
+static uint32_t frame_ops;
+static uint32_t frame_pixels;
+static uint32_t frame_ns;
+static struct timespec frame_start;
+
+// Bitmaps
+
+static int bits_per_pixel(GBitmapFormat format) {
+  switch (format) {
+    case GBitmapFormat1Bit:
+    case GBitmapFormat1BitPalette:
+      return 1;
+    case GBitmapFormat2BitPalette:
+      return 2;
+    case GBitmapFormat4BitPalette:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+static int palette_size(GBitmapFormat format) {
+  return format == GBitmapFormat1BitPalette || format == GBitmapFormat2BitPalette ||
+    format == GBitmapFormat4BitPalette ? 1 << bits_per_pixel(format) : 0;
+}
+
+// 1-bit rows are padded to whole words, as on aplite
+static uint16_t row_size_for(GSize size, GBitmapFormat format) {
+  if (format == GBitmapFormat1Bit) {
+    return (size.w + 31) / 32 * 4;
+  }
+  return (size.w * bits_per_pixel(format) + 7) / 8;
+}
+
+static GBitmap *create_bitmap(GSize size, GBitmapFormat format) {
+  uint16_t row_size = row_size_for(size, format);
+  int heap_bytes = sizeof(GBitmap) + row_size * size.h;
+  if (heap_bytes_free() < (size_t) heap_bytes) {
+    return NULL;
+  }
+  GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+  *bitmap = (GBitmap) {
+    .data = calloc(size.h, row_size),
+    .row_size = row_size,
+    .format = format,
+    .bounds = { GPointZero, size },
+    .owns_data = true,
+    .heap_bytes = heap_bytes
+  };
+  host_heap_add(heap_bytes);
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+  if (resource_id >= host_resource_count || host_resources[resource_id].type != HOST_RESOURCE_BITMAP) {
+    return NULL;
+  }
+  const HostResource *resource = &host_resources[resource_id];
+  GBitmap *bitmap = create_bitmap(resource->size, resource->format);
+  if (!bitmap) {
+    return NULL;
+  }
+  memcpy(bitmap->data, resource->data, bitmap->row_size * resource->size.h);
+  int colors = palette_size(resource->format);
+  if (colors) {
+    bitmap->palette = malloc(colors * sizeof(GColor));
+    memcpy(bitmap->palette, resource->palette, colors * sizeof(GColor));
+    bitmap->owns_palette = true;
+  }
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  return create_bitmap(size, format);
+}
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette,
+                                           bool free_on_destroy) {
+  GBitmap *bitmap = create_bitmap(size, format);
+  if (bitmap) {
+    gbitmap_set_palette(bitmap, palette, free_on_destroy);
+  }
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base, GRect sub_rect) {
+  GBitmap *bitmap = malloc(sizeof(GBitmap));
+  *bitmap = *base;
+  bitmap->bounds = GRect(base->bounds.origin.x + sub_rect.origin.x, base->bounds.origin.y + sub_rect.origin.y,
+                         sub_rect.size.w, sub_rect.size.h);
+  bitmap->owns_data = false;
+  bitmap->owns_palette = false;
+  bitmap->heap_bytes = sizeof(GBitmap);
+  host_heap_add(bitmap->heap_bytes);
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (!bitmap) {
+    return;
+  }
+  host_heap_add(-bitmap->heap_bytes);
+  if (bitmap->owns_data) {
+    free(bitmap->data);
+  }
+  if (bitmap->owns_palette) {
+    free(bitmap->palette);
+  }
+  free(bitmap);
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->row_size;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+GColor *gbitmap_get_palette(const GBitmap *bitmap) {
+  return bitmap->palette;
+}
+
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy) {
+  if (bitmap->owns_palette && bitmap->palette != palette) {
+    free(bitmap->palette);
+  }
+  bitmap->palette = palette;
+  bitmap->owns_palette = free_on_destroy;
+}
+
+// The visible span of a display row, all of it unless the display is round
+static void frame_row_span(int y, int *min_x, int *max_x) {
+  #ifdef PBL_ROUND
+  static int16_t spans[HOST_SCREEN_HEIGHT];
+  if (!spans[y]) {
+    double radius = HOST_SCREEN_WIDTH / 2.0;
+    double dy = y + 0.5 - radius;
+    spans[y] = (int16_t) (sqrt(radius * radius - dy * dy) + 0.5);
+  }
+  *min_x = HOST_SCREEN_WIDTH / 2 - spans[y];
+  *max_x = HOST_SCREEN_WIDTH / 2 + spans[y] - 1;
+  #else
+  *min_x = 0;
+  *max_x = HOST_SCREEN_WIDTH - 1;
+  #endif
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+  GBitmapDataRowInfo info = {
+    .data = bitmap->data + y * bitmap->row_size,
+    .min_x = bitmap->bounds.origin.x,
+    .max_x = bitmap->bounds.origin.x + bitmap->bounds.size.w - 1
+  };
+  if (bitmap == &frame) {
+    int min_x, max_x;
+    frame_row_span(y, &min_x, &max_x);
+    info.min_x = min_x;
+    info.max_x = max_x;
+  }
+  return info;
+}
+
+// Fonts, system fonts are never freed
+
+static struct HostFont gothic_18 = { .height = 18 };
+static struct HostFont gothic_24_bold = { .height = 24 };
+
+GFont fonts_get_system_font(const char *font_key) {
+  return strcmp(font_key, FONT_KEY_GOTHIC_24_BOLD) == 0 ? &gothic_24_bold : &gothic_18;
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  return resource_id < host_resource_count ? &host_resources[resource_id] : NULL;
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+  const HostResource *resource = handle;
+  if (!resource || resource->type != HOST_RESOURCE_FONT) {
+    return NULL;
+  }
+  // glyphs of the digits and separators the resource is limited to
+  int heap_bytes = resource->font_height * resource->font_height;
+  if (heap_bytes_free() < (size_t) heap_bytes) {
+    return NULL;
+  }
+  GFont font = malloc(sizeof(struct HostFont));
+  *font = (struct HostFont) { .height = resource->font_height, .is_custom = true };
+  host_heap_add(heap_bytes);
+  return font;
+}
+
+void fonts_unload_custom_font(GFont font) {
+  if (font && font->is_custom) {
+    host_heap_add(-font->height * font->height);
+    free(font);
+  }
+}
+
+// Pixels
+
+// Columns of the glyphs from ' ' to '~', least significant bit on top
+static const uint8_t font_5x8[][5] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 },
+  { 0x14, 0x7f, 0x14, 0x7f, 0x14 }, { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+  { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x08, 0x07, 0x03, 0x00 }, { 0x00, 0x1c, 0x22, 0x41, 0x00 },
+  { 0x00, 0x41, 0x22, 0x1c, 0x00 }, { 0x2a, 0x1c, 0x7f, 0x1c, 0x2a }, { 0x08, 0x08, 0x3e, 0x08, 0x08 },
+  { 0x00, 0x80, 0x70, 0x30, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x00, 0x60, 0x60, 0x00 },
+  { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 },
+  { 0x72, 0x49, 0x49, 0x49, 0x46 }, { 0x21, 0x41, 0x49, 0x4d, 0x33 }, { 0x18, 0x14, 0x12, 0x7f, 0x10 },
+  { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3c, 0x4a, 0x49, 0x49, 0x31 }, { 0x41, 0x21, 0x11, 0x09, 0x07 },
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x46, 0x49, 0x49, 0x29, 0x1e }, { 0x00, 0x00, 0x14, 0x00, 0x00 },
+  { 0x00, 0x40, 0x34, 0x00, 0x00 }, { 0x00, 0x08, 0x14, 0x22, 0x41 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+  { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x59, 0x09, 0x06 }, { 0x3e, 0x41, 0x5d, 0x59, 0x4e },
+  { 0x7c, 0x12, 0x11, 0x12, 0x7c }, { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 },
+  { 0x7f, 0x41, 0x41, 0x41, 0x3e }, { 0x7f, 0x49, 0x49, 0x49, 0x41 }, { 0x7f, 0x09, 0x09, 0x09, 0x01 },
+  { 0x3e, 0x41, 0x41, 0x51, 0x73 }, { 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 },
+  { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 }, { 0x7f, 0x40, 0x40, 0x40, 0x40 },
+  { 0x7f, 0x02, 0x1c, 0x02, 0x7f }, { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e },
+  { 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e }, { 0x7f, 0x09, 0x19, 0x29, 0x46 },
+  { 0x26, 0x49, 0x49, 0x49, 0x32 }, { 0x03, 0x01, 0x7f, 0x01, 0x03 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f },
+  { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x3f, 0x40, 0x38, 0x40, 0x3f }, { 0x63, 0x14, 0x08, 0x14, 0x63 },
+  { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x59, 0x49, 0x4d, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x41 },
+  { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x41, 0x7f }, { 0x04, 0x02, 0x01, 0x02, 0x04 },
+  { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x03, 0x07, 0x08, 0x00 }, { 0x20, 0x54, 0x54, 0x78, 0x40 },
+  { 0x7f, 0x28, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x28 }, { 0x38, 0x44, 0x44, 0x28, 0x7f },
+  { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x00, 0x08, 0x7e, 0x09, 0x02 }, { 0x18, 0xa4, 0xa4, 0x9c, 0x78 },
+  { 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 }, { 0x20, 0x40, 0x40, 0x3d, 0x00 },
+  { 0x7f, 0x10, 0x28, 0x44, 0x00 }, { 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x78, 0x04, 0x78 },
+  { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0xfc, 0x18, 0x24, 0x24, 0x18 },
+  { 0x18, 0x24, 0x24, 0x18, 0xfc }, { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x24 },
+  { 0x04, 0x04, 0x3f, 0x44, 0x24 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c }, { 0x1c, 0x20, 0x40, 0x20, 0x1c },
+  { 0x3c, 0x40, 0x30, 0x40, 0x3c }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x4c, 0x90, 0x90, 0x90, 0x7c },
+  { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x7f, 0x00, 0x00 },
+  { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x02, 0x01, 0x02, 0x04, 0x02 }
+};
+
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 8
+
+static bool is_on_screen(int x, int y) {
+  if (y < 0 || y >= HOST_SCREEN_HEIGHT) {
+    return false;
+  }
+  int min_x, max_x;
+  frame_row_span(y, &min_x, &max_x);
+  return x >= min_x && x <= max_x;
+}
+
+static bool read_bit(const uint8_t *row, int x) {
+  return row[x / 8] & (1 << x % 8);
+}
+
+#ifndef PBL_COLOR
+static void write_bit(uint8_t *row, int x, bool is_set) {
+  if (is_set) {
+    row[x / 8] |= 1 << x % 8;
+  } else {
+    row[x / 8] &= ~(1 << x % 8);
+  }
+}
+
+// Any color on aplite: dark ones black, light ones white, the rest a 50% dither
+static bool bw_color_at(GColor color, int x, int y) {
+  int luminance = color.r + color.g + color.b;
+  return luminance >= 7 || (luminance >= 3 && (x + y) % 2 == 0);
+}
+#endif
+
+// Source pixel of any bitmap format, palettized rows are packed most significant bits first
+static GColor read_bitmap(const GBitmap *bitmap, int x, int y) {
+  const uint8_t *row = bitmap->data + y * bitmap->row_size;
+  int bits = bits_per_pixel(bitmap->format);
+  if (bitmap->format == GBitmapFormat1Bit) {
+    return read_bit(row, x) ? GColorWhite : GColorBlack;
+  } else if (bits == 8) {
+    return (GColor) { .argb = row[x] };
+  }
+  int per_byte = 8 / bits;
+  int shift = (per_byte - 1 - x % per_byte) * bits;
+  return bitmap->palette[(row[x / per_byte] >> shift) & ((1 << bits) - 1)];
+}
+
+static bool is_clipped(GContext *ctx, int x, int y) {
+  return x < ctx->clip.origin.x || y < ctx->clip.origin.y ||
+    x >= ctx->clip.origin.x + ctx->clip.size.w || y >= ctx->clip.origin.y + ctx->clip.size.h ||
+    !is_on_screen(x, y);
+}
+
+// Fills, strokes and text: a clear color draws nothing, any other is opaque
+static void put_color(GContext *ctx, int x, int y, GColor color) {
+  if (color.a == 0 || is_clipped(ctx, x, y)) {
+    return;
+  }
+  frame_pixels++;
+  uint8_t *row = frame.data + y * frame.row_size;
+  #ifdef PBL_COLOR
+  color.a = 3;
+  row[x] = color.argb;
+  #else
+  write_bit(row, x, bw_color_at(color, x, y));
+  #endif
+}
+
+// Bitmaps go through the compositing mode
+static void put_bitmap_pixel(GContext *ctx, int x, int y, GColor src) {
+  if (is_clipped(ctx, x, y)) {
+    return;
+  }
+  frame_pixels++;
+  uint8_t *row = frame.data + y * frame.row_size;
+  #ifdef PBL_COLOR
+  GColor dst = { .argb = row[x] };
+  if (ctx->mode == GCompOpAssign) {
+    dst = src;
+  } else if (src.a == 3) {
+    dst = src;
+  } else if (src.a > 0) {
+    dst.r = (src.r * src.a + dst.r * (3 - src.a)) / 3;
+    dst.g = (src.g * src.a + dst.g * (3 - src.a)) / 3;
+    dst.b = (src.b * src.a + dst.b * (3 - src.a)) / 3;
+  }
+  dst.a = 3;
+  row[x] = dst.argb;
+  #else
+  bool s = bw_color_at(src, x, y);
+  bool d = read_bit(row, x);
+  switch (ctx->mode) {
+    case GCompOpAssign:
+      d = s;
+      break;
+    case GCompOpAssignInverted:
+      d = !s;
+      break;
+    case GCompOpOr:
+      d = d || s;
+      break;
+    case GCompOpAnd:
+      d = d && s;
+      break;
+    case GCompOpClear:
+      d = d && !s;
+      break;
+    case GCompOpSet:
+      d = d || !s;
+      break;
+  }
+  write_bit(row, x, d);
+  #endif
+}
+
+// Drawing
+
+GContext *host_graphics_frame_begin(GColor background) {
+  context = (GContext) {
+    .clip = frame.bounds,
+    .stroke_color = GColorBlack,
+    .fill_color = GColorBlack,
+    .text_color = GColorBlack,
+    .mode = GCompOpAssign
+  };
+  frame_ops = 0;
+  frame_pixels = 0;
+  clock_gettime(CLOCK_MONOTONIC, &frame_start);
+  for (int y = 0; y < HOST_SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < HOST_SCREEN_WIDTH; x++) {
+      put_color(&context, x, y, background);
+    }
+  }
+  return &context;
+}
+
+void host_graphics_layer_begin(GContext *ctx, GPoint origin, GRect clip) {
+  ctx->origin = origin;
+  ctx->clip = clip;
+}
+
+void host_graphics_frame_end(GContext *ctx) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  frame_ns = (end.tv_sec - frame_start.tv_sec) * 1000000000L + end.tv_nsec - frame_start.tv_nsec;
+}
+
+typedef struct FrameHeader {
+  char name[32];
+  uint16_t width;
+  uint16_t height;
+  uint32_t ops;
+  uint32_t pixels;
+  uint32_t ns;
+} FrameHeader;
+
+void host_graphics_write_frame(const char *name) {
+  FILE *file = fopen("frames.raw", "ab");
+  if (!file) {
+    perror("frames.raw");
+    exit(1);
+  }
+  FrameHeader header = {
+    .width = HOST_SCREEN_WIDTH,
+    .height = HOST_SCREEN_HEIGHT,
+    .ops = frame_ops,
+    .pixels = frame_pixels,
+    .ns = frame_ns
+  };
+  strncpy(header.name, name, sizeof(header.name) - 1);
+  fwrite(&header, sizeof(header), 1, file);
+  for (int y = 0; y < HOST_SCREEN_HEIGHT; y++) {
+    uint8_t pixels[HOST_SCREEN_WIDTH];
+    const uint8_t *row = frame.data + y * frame.row_size;
+    for (int x = 0; x < HOST_SCREEN_WIDTH; x++) {
+      #ifdef PBL_COLOR
+      pixels[x] = is_on_screen(x, y) ? row[x] | 0xc0 : GColorBlackARGB8;
+      #else
+      pixels[x] = read_bit(row, x) ? GColorWhiteARGB8 : GColorBlackARGB8;
+      #endif
+    }
+    fwrite(pixels, sizeof(pixels), 1, file);
+  }
+  fclose(file);
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  ctx->text_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->mode = mode;
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+  frame_ops++;
+  int x0 = ctx->origin.x + rect.origin.x;
+  int y0 = ctx->origin.y + rect.origin.y;
+  for (int x = x0; x < x0 + rect.size.w; x++) {
+    put_color(ctx, x, y0, ctx->stroke_color);
+    put_color(ctx, x, y0 + rect.size.h - 1, ctx->stroke_color);
+  }
+  for (int y = y0 + 1; y < y0 + rect.size.h - 1; y++) {
+    put_color(ctx, x0, y, ctx->stroke_color);
+    put_color(ctx, x0 + rect.size.w - 1, y, ctx->stroke_color);
+  }
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corners) {
+  frame_ops++;
+  int x0 = ctx->origin.x + rect.origin.x;
+  int y0 = ctx->origin.y + rect.origin.y;
+  for (int y = y0; y < y0 + rect.size.h; y++) {
+    for (int x = x0; x < x0 + rect.size.w; x++) {
+      put_color(ctx, x, y, ctx->fill_color);
+    }
+  }
+}
+
+// The bitmap is tiled over rect, as the SDK does
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  frame_ops++;
+  GRect bounds = bitmap->bounds;
+  if (bounds.size.w <= 0 || bounds.size.h <= 0) {
+    return;
+  }
+  int x0 = ctx->origin.x + rect.origin.x;
+  int y0 = ctx->origin.y + rect.origin.y;
+  for (int y = 0; y < rect.size.h; y++) {
+    for (int x = 0; x < rect.size.w; x++) {
+      GColor src = read_bitmap(bitmap, bounds.origin.x + x % bounds.size.w, bounds.origin.y + y % bounds.size.h);
+      put_bitmap_pixel(ctx, x0 + x, y0 + y, src);
+    }
+  }
+}
+
+static int font_scale(GFont font) {
+  return MAX(font->height / 10, 1);
+}
+
+static int text_width(const char *text, GFont font) {
+  int scale = font_scale(font);
+  int length = strlen(text);
+  return length ? (length * (GLYPH_WIDTH + 1) - 1) * scale : 0;
+}
+
+// One line, glyphs vertically centered in the font's line height
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow, GTextAlignment alignment, GTextAttributes *attributes) {
+  frame_ops++;
+  if (!text || !font) {
+    return;
+  }
+  GRect clip = ctx->clip;
+  GRect box_on_screen = { { ctx->origin.x + box.origin.x, ctx->origin.y + box.origin.y }, box.size };
+  int x0 = MAX(clip.origin.x, box_on_screen.origin.x);
+  int y0 = MAX(clip.origin.y, box_on_screen.origin.y);
+  int x1 = MIN(clip.origin.x + clip.size.w, box_on_screen.origin.x + box.size.w);
+  int y1 = MIN(clip.origin.y + clip.size.h, box_on_screen.origin.y + box.size.h);
+  ctx->clip = GRect(x0, y0, MAX(x1 - x0, 0), MAX(y1 - y0, 0));
+
+  int scale = font_scale(font);
+  int width = text_width(text, font);
+  int x = box_on_screen.origin.x;
+  if (alignment == GTextAlignmentCenter) {
+    x += (box.size.w - width) / 2;
+  } else if (alignment == GTextAlignmentRight) {
+    x += box.size.w - width;
+  }
+  int y = box_on_screen.origin.y + (font->height - GLYPH_HEIGHT * scale) / 2;
+  for (const char *c = text; *c; c++, x += (GLYPH_WIDTH + 1) * scale) {
+    if (*c < ' ' || *c > '~') {
+      continue;
+    }
+    const uint8_t *columns = font_5x8[*c - ' '];
+    for (int column = 0; column < GLYPH_WIDTH * scale; column++) {
+      for (int row = 0; row < GLYPH_HEIGHT * scale; row++) {
+        if (columns[column / scale] & (1 << row / scale)) {
+          put_color(ctx, x + column, y + row, ctx->text_color);
+        }
+      }
+    }
+  }
+  ctx->clip = clip;
+}
+
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow, GTextAlignment alignment) {
+  return GSize(MIN(text_width(text, font), box.size.w), MIN(font->height, box.size.h));
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  frame_ops++;
+  return &frame;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  return buffer == &frame;
+}
+
+#define MENU_CELL_MARGIN 5
+
+void menu_cell_basic_draw(GContext *ctx, const Layer *cell_layer, const char *title, const char *subtitle,
+                          GBitmap *icon) {
+  GRect bounds = layer_get_bounds(cell_layer);
+  GFont title_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+  GFont subtitle_font = fonts_get_system_font(FONT_KEY_GOTHIC_18);
+  int title_height = subtitle ? title_font->height : bounds.size.h;
+  graphics_draw_text(ctx, title, title_font, GRect(MENU_CELL_MARGIN, 0, bounds.size.w - MENU_CELL_MARGIN,
+                     title_height), GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+  if (subtitle) {
+    graphics_draw_text(ctx, subtitle, subtitle_font, GRect(MENU_CELL_MARGIN, title_height,
+                       bounds.size.w - MENU_CELL_MARGIN, bounds.size.h - title_height),
+                       GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+  }
+}
+
+void menu_cell_basic_header_draw(GContext *ctx, const Layer *cell_layer, const char *title) {
+  GRect bounds = layer_get_bounds(cell_layer);
+  graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_18), GRect(MENU_CELL_MARGIN, 0,
+                     bounds.size.w - MENU_CELL_MARGIN, bounds.size.h), GTextOverflowModeTrailingEllipsis,
+                     GTextAlignmentLeft, NULL);
+}
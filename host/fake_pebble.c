@@ -0,0 +1,1617 @@
+// The simulated OS: clock, timers, ticks, windows and layers, input,
+// persistent storage, wakeups and the phone. Everything that has to outlive a launch
+// lives in one shared mapping, the rest is per launch process.
+#include <stdarg.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "host.h"
+
+#define HOST_PERSIST_KEYS 32
+#define HOST_WAKEUPS 8
+#define HOST_TIMERS 64
+#define HOST_ANIMATIONS 16
+#define HOST_WINDOWS 8
+#define HOST_FRAME_MS 33
+#define HOST_INPUT_DELAY_MS 1000
+#define DEFAULT_ANIMATION_MS 250
+#define MENU_CELL_HEIGHT 44
+#define HOST_DICT_SIZE 1024
+#define HOST_INBOX 8
+#define HOST_PHONE_LATENCY_MS 500
+
+#define NEVER INT64_MAX
+
+typedef struct PersistEntry {
+  bool used;
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+typedef struct WakeupEntry {
+  WakeupId id;
+  time_t at;
+} WakeupEntry;
+
+typedef struct HostShared {
+  int64_t clock_ms;
+  size_t next_action;
+  PersistEntry persist[HOST_PERSIST_KEYS];
+  WakeupEntry wakeups[HOST_WAKEUPS];
+  WakeupId last_wakeup_id;
+  bool is_phone_connected;
+  HostStats stats;
+  HostStats hours[24];
+} HostShared;
+
+static HostShared *shared;
+
+// Counted for the day and for the hour of the simulated clock
+#define COUNT(field, n) \
+  (shared->stats.field += (n), shared->hours[shared->clock_ms / 1000 / SECONDS_PER_HOUR % 24].field += (n))
+
+// Per launch
+
+static AppLaunchReason reason;
+static const HostAction *actions;
+static size_t action_count;
+static int64_t input_floor_ms;
+static int64_t until_ms;
+// Frames still to write for the running HOST_CAPTURE
+static const char *capture_name;
+static int capture_frames;
+static int capture_index;
+
+// Clock
+
+time_t host_time(time_t *t) {
+  time_t now = shared->clock_ms / 1000;
+  if (t) {
+    *t = now;
+  }
+  return now;
+}
+
+uint16_t time_ms(time_t *t, uint16_t *ms) {
+  host_time(t);
+  uint16_t now_ms = shared->clock_ms % 1000;
+  if (ms) {
+    *ms = now_ms;
+  }
+  return now_ms;
+}
+
+time_t host_now(void) {
+  return host_time(NULL);
+}
+
+static void advance_to(int64_t ms) {
+  if (ms > shared->clock_ms) {
+    shared->clock_ms = ms;
+  }
+}
+
+int32_t sin_lookup(int32_t angle) {
+  return (int32_t) lround(sin(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return (int32_t) lround(cos(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+void app_log(uint8_t level, const char *file, int line, const char *fmt, ...) {
+  if (level > APP_LOG_LEVEL_WARNING && !getenv("HOST_LOG")) {
+    return;
+  }
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "[%ld] %s:%d ", (long) host_now(), file, line);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+// App timers
+
+struct AppTimer {
+  bool is_pending;
+  int64_t due_ms;
+  uint32_t order;
+  AppTimerCallback callback;
+  void *data;
+};
+
+static AppTimer timers[HOST_TIMERS];
+static uint32_t timer_order;
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *data) {
+  for (int i = 0; i < HOST_TIMERS; i++) {
+    AppTimer *timer = &timers[(timer_order + i) % HOST_TIMERS];
+    if (!timer->is_pending) {
+      *timer = (AppTimer) {
+        .is_pending = true,
+        .due_ms = shared->clock_ms + timeout_ms,
+        .order = timer_order++,
+        .callback = callback,
+        .data = data
+      };
+      return timer;
+    }
+  }
+  fprintf(stderr, "out of app timers\n");
+  exit(1);
+}
+
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms) {
+  if (!timer || !timer->is_pending) {
+    return false;
+  }
+  timer->due_ms = shared->clock_ms + new_timeout_ms;
+  timer->order = timer_order++;
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+  if (timer) {
+    timer->is_pending = false;
+  }
+}
+
+static AppTimer *next_timer(void) {
+  AppTimer *next = NULL;
+  for (int i = 0; i < HOST_TIMERS; i++) {
+    AppTimer *timer = &timers[i];
+    if (timer->is_pending &&
+        (!next || timer->due_ms < next->due_ms || (timer->due_ms == next->due_ms && timer->order < next->order))) {
+      next = timer;
+    }
+  }
+  return next;
+}
+
+// Services
+
+static TickHandler tick_handler;
+static TimeUnits tick_units;
+static int64_t next_tick_ms = NEVER;
+
+static int tick_period(void) {
+  return tick_units & SECOND_UNIT ? 1 : tick_units & MINUTE_UNIT ? SECONDS_PER_MINUTE : SECONDS_PER_HOUR;
+}
+
+void tick_timer_service_subscribe(TimeUnits units, TickHandler handler) {
+  tick_handler = handler;
+  tick_units = units;
+  int period = tick_period();
+  next_tick_ms = (host_now() / period + 1) * period * 1000;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  tick_handler = NULL;
+  next_tick_ms = NEVER;
+}
+
+static AppFocusHandlers focus_handlers;
+
+void app_focus_service_subscribe_handlers(AppFocusHandlers handlers) {
+  focus_handlers = handlers;
+}
+
+void app_focus_service_unsubscribe(void) {
+  focus_handlers = (AppFocusHandlers) { 0 };
+}
+
+// The phone is in reach between HOST_PHONE_CONNECT and HOST_PHONE_DISCONNECT,
+// and only if there is a stand-in to talk to
+static FILE *phone_in;
+static FILE *phone_out;
+static ConnectionHandlers connection_handlers;
+
+void connection_service_subscribe(ConnectionHandlers handlers) {
+  connection_handlers = handlers;
+}
+
+void connection_service_unsubscribe(void) {
+  connection_handlers = (ConnectionHandlers) { 0 };
+}
+
+bool connection_service_peek_pebble_app_connection(void) {
+  return phone_in && shared->is_phone_connected;
+}
+
+void vibes_short_pulse(void) {
+  COUNT(vibes, 1);
+}
+
+void vibes_double_pulse(void) {
+  COUNT(vibes, 1);
+}
+
+void vibes_long_pulse(void) {
+  COUNT(vibes, 1);
+}
+
+void light_enable_interaction(void) {
+}
+
+// Only bitmaps and fonts are counted, they are what fills the heap on the watch
+static int heap_used;
+
+void host_heap_add(int bytes) {
+  heap_used += bytes;
+}
+
+size_t heap_bytes_used(void) {
+  return heap_used;
+}
+
+size_t heap_bytes_free(void) {
+  return HOST_HEAP_SIZE - MIN(heap_used, HOST_HEAP_SIZE);
+}
+
+AppLaunchReason launch_reason(void) {
+  return reason;
+}
+
+// AppMessage. Messages reach the phone HOST_PHONE_LATENCY_MS after they are
+// sent and its answers take as long again, the phone itself answers at once.
+
+struct DictionaryIterator {
+  uint16_t size;
+  uint8_t buffer[HOST_DICT_SIZE] __attribute__((aligned(4)));
+};
+
+typedef struct InboxMessage {
+  int64_t due_ms;
+  DictionaryIterator dict;
+} InboxMessage;
+
+static InboxMessage inbox[HOST_INBOX];
+static size_t inbox_count;
+static AppMessageInboxReceived inbox_received;
+static DictionaryIterator outbox;
+
+void host_phone_open(char *const command[]) {
+  int to_phone[2];
+  int from_phone[2];
+  if (pipe(to_phone) || pipe(from_phone)) {
+    perror("pipe");
+    exit(1);
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if (pid == 0) {
+    dup2(to_phone[0], STDIN_FILENO);
+    dup2(from_phone[1], STDOUT_FILENO);
+    close(to_phone[1]);
+    close(from_phone[0]);
+    execvp(command[0], command);
+    perror(command[0]);
+    _exit(1);
+  }
+  close(to_phone[0]);
+  close(from_phone[1]);
+  phone_in = fdopen(to_phone[1], "w");
+  phone_out = fdopen(from_phone[0], "r");
+}
+
+void host_phone_event(const char *event, HostPhoneReply reply, void *context) {
+  if (!phone_in) {
+    return;
+  }
+  fprintf(phone_in, "%s\n", event);
+  fflush(phone_in);
+  char line[HOST_DICT_SIZE];
+  while (fgets(line, sizeof(line), phone_out)) {
+    line[strcspn(line, "\n")] = '\0';
+    if (strcmp(line, "end") == 0) {
+      return;
+    }
+    if (reply) {
+      reply(line, context);
+    }
+  }
+  fprintf(stderr, "the phone stopped answering at %ld\n", (long) host_now());
+  exit(1);
+}
+
+static Tuple *next_tuple(const DictionaryIterator *iter, Tuple *tuple) {
+  uint8_t *next = tuple ? (uint8_t *) tuple + sizeof(Tuple) + (tuple->length + 3) / 4 * 4 : (uint8_t *) iter->buffer;
+  return next < iter->buffer + iter->size ? (Tuple *) next : NULL;
+}
+
+static DictionaryResult dict_write(DictionaryIterator *iter, uint32_t key, TupleType type, const void *data,
+                                   uint16_t length) {
+  size_t size = sizeof(Tuple) + (length + 3) / 4 * 4;
+  if (!iter) {
+    return DICT_INVALID_ARGS;
+  }
+  if (iter->size + size > sizeof(iter->buffer)) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  Tuple *tuple = (Tuple *) (iter->buffer + iter->size);
+  tuple->key = key;
+  tuple->type = type;
+  tuple->length = length;
+  memcpy(tuple->value, data, length);
+  iter->size += size;
+  return DICT_OK;
+}
+
+// A line from the phone, key=value pairs of integers
+static void queue_phone_message(const char *line, void *context) {
+  if (inbox_count == HOST_INBOX) {
+    return;
+  }
+  InboxMessage *message = &inbox[inbox_count++];
+  message->due_ms = *(int64_t *) context;
+  message->dict.size = 0;
+  uint32_t key;
+  int32_t value;
+  int used;
+  while (sscanf(line, " %u=%d%n", &key, &value, &used) == 2) {
+    dict_write(&message->dict, key, TUPLE_INT, &value, sizeof(value));
+    line += used;
+  }
+}
+
+static void tell_phone(const char *event, int64_t answer_ms) {
+  int64_t due_ms = shared->clock_ms + answer_ms;
+  host_phone_event(event, queue_phone_message, &due_ms);
+}
+
+static InboxMessage *next_inbox_message(void) {
+  InboxMessage *next = NULL;
+  for (size_t i = 0; i < inbox_count; i++) {
+    if (!next || inbox[i].due_ms < next->due_ms) {
+      next = &inbox[i];
+    }
+  }
+  return next;
+}
+
+static void deliver_inbox_message(InboxMessage *message) {
+  DictionaryIterator dict = message->dict;
+  memmove(message, message + 1, (inbox + inbox_count - message - 1) * sizeof(InboxMessage));
+  inbox_count--;
+  if (inbox_received) {
+    inbox_received(&dict, NULL);
+  }
+}
+
+AppMessageResult app_message_open(uint32_t size_inbound, uint32_t size_outbound) {
+  return APP_MSG_OK;
+}
+
+void app_message_register_inbox_received(AppMessageInboxReceived callback) {
+  inbox_received = callback;
+}
+
+// Sends fail right away or are delivered, there is nothing to report later
+void app_message_register_outbox_failed(AppMessageOutboxFailed callback) {
+}
+
+void app_message_deregister_callbacks(void) {
+  inbox_received = NULL;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (!connection_service_peek_pebble_app_connection()) {
+    return APP_MSG_NOT_CONNECTED;
+  }
+  outbox.size = 0;
+  *iterator = &outbox;
+  return APP_MSG_OK;
+}
+
+// The outbox goes to the phone as JSON, keyed by key number
+AppMessageResult app_message_outbox_send(void) {
+  if (!connection_service_peek_pebble_app_connection()) {
+    return APP_MSG_NOT_CONNECTED;
+  }
+  char event[HOST_DICT_SIZE * 5];
+  int size = snprintf(event, sizeof(event), "{\"event\": \"appmessage\", \"payload\": {");
+  for (Tuple *tuple = next_tuple(&outbox, NULL); tuple; tuple = next_tuple(&outbox, tuple)) {
+    size += snprintf(event + size, sizeof(event) - size, "%s\"%u\": ", tuple == (Tuple *) outbox.buffer ? "" : ", ",
+                     (unsigned) tuple->key);
+    if (tuple->type == TUPLE_BYTE_ARRAY) {
+      for (int i = 0; i < tuple->length; i++) {
+        size += snprintf(event + size, sizeof(event) - size, "%s%u", i ? ", " : "[", tuple->value->data[i]);
+      }
+      size += snprintf(event + size, sizeof(event) - size, tuple->length ? "]" : "[]");
+    } else if (tuple->type == TUPLE_UINT) {
+      size += snprintf(event + size, sizeof(event) - size, "%u", tuple->length == 1 ? tuple->value->uint8 : tuple->value->uint32);
+    } else {
+      size += snprintf(event + size, sizeof(event) - size, "%d", tuple->length == 1 ? tuple->value->int8 : tuple->value->int32);
+    }
+  }
+  snprintf(event + size, sizeof(event) - size, "}}");
+  tell_phone(event, 2 * HOST_PHONE_LATENCY_MS);
+  return APP_MSG_OK;
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, uint32_t key, uint8_t value) {
+  return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, uint32_t key, int32_t value) {
+  return dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, uint32_t key, const uint8_t *data, uint16_t size) {
+  return dict_write(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, uint32_t key) {
+  for (Tuple *tuple = next_tuple(iter, NULL); tuple; tuple = next_tuple(iter, tuple)) {
+    if (tuple->key == key) {
+      return tuple;
+    }
+  }
+  return NULL;
+}
+
+uint32_t dict_calc_buffer_size(uint8_t tuple_count, ...) {
+  va_list sizes;
+  va_start(sizes, tuple_count);
+  uint32_t size = 1;
+  for (int i = 0; i < tuple_count; i++) {
+    size += sizeof(Tuple) + va_arg(sizes, uint32_t);
+  }
+  va_end(sizes);
+  return size;
+}
+
+// Persistent storage, every write is counted whether it changes anything or not
+
+static PersistEntry *find_entry(uint32_t key) {
+  for (int i = 0; i < HOST_PERSIST_KEYS; i++) {
+    if (shared->persist[i].used && shared->persist[i].key == key) {
+      return &shared->persist[i];
+    }
+  }
+  return NULL;
+}
+
+static int write_entry(uint32_t key, const void *data, size_t size) {
+  size = MIN(size, PERSIST_DATA_MAX_LENGTH);
+  PersistEntry *entry = find_entry(key);
+  for (int i = 0; i < HOST_PERSIST_KEYS && !entry; i++) {
+    if (!shared->persist[i].used) {
+      entry = &shared->persist[i];
+    }
+  }
+  if (!entry) {
+    return E_OUT_OF_RESOURCES;
+  }
+  entry->used = true;
+  entry->key = key;
+  entry->size = size;
+  memcpy(entry->data, data, size);
+  COUNT(persist_writes, 1);
+  COUNT(persist_bytes, size);
+  return size;
+}
+
+bool persist_exists(uint32_t key) {
+  return find_entry(key) != NULL;
+}
+
+int persist_get_size(uint32_t key) {
+  PersistEntry *entry = find_entry(key);
+  return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int32_t persist_read_int(uint32_t key) {
+  int32_t value = 0;
+  PersistEntry *entry = find_entry(key);
+  if (entry) {
+    memcpy(&value, entry->data, MIN(entry->size, sizeof(value)));
+  }
+  return value;
+}
+
+bool persist_read_bool(uint32_t key) {
+  PersistEntry *entry = find_entry(key);
+  return entry && entry->size > 0 && entry->data[0];
+}
+
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size) {
+  PersistEntry *entry = find_entry(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  size_t size = MIN(entry->size, buffer_size);
+  memcpy(buffer, entry->data, size);
+  return size;
+}
+
+status_t persist_write_int(uint32_t key, int32_t value) {
+  return write_entry(key, &value, sizeof(value)) < 0 ? E_OUT_OF_RESOURCES : S_SUCCESS;
+}
+
+status_t persist_write_bool(uint32_t key, bool value) {
+  uint8_t byte = value;
+  return write_entry(key, &byte, sizeof(byte)) < 0 ? E_OUT_OF_RESOURCES : S_SUCCESS;
+}
+
+int persist_write_data(uint32_t key, const void *data, size_t size) {
+  return write_entry(key, data, size);
+}
+
+status_t persist_delete(uint32_t key) {
+  PersistEntry *entry = find_entry(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->used = false;
+  return S_SUCCESS;
+}
+
+// Wakeups, the app may hold HOST_WAKEUPS of them but none within a minute of another
+
+WakeupId wakeup_schedule(time_t timestamp, int32_t cookie, bool notify_if_missed) {
+  WakeupEntry *free_entry = NULL;
+  for (int i = 0; i < HOST_WAKEUPS; i++) {
+    WakeupEntry *entry = &shared->wakeups[i];
+    if (!entry->id) {
+      free_entry = free_entry ? free_entry : entry;
+    } else if (labs(entry->at - timestamp) < SECONDS_PER_MINUTE) {
+      return E_RANGE;
+    }
+  }
+  if (!free_entry) {
+    return E_OUT_OF_RESOURCES;
+  }
+  *free_entry = (WakeupEntry) { .id = ++shared->last_wakeup_id, .at = timestamp };
+  return free_entry->id;
+}
+
+void wakeup_cancel(WakeupId wakeup_id) {
+  for (int i = 0; i < HOST_WAKEUPS; i++) {
+    if (shared->wakeups[i].id == wakeup_id) {
+      shared->wakeups[i].id = 0;
+    }
+  }
+}
+
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp) {
+  for (int i = 0; i < HOST_WAKEUPS; i++) {
+    if (wakeup_id > 0 && shared->wakeups[i].id == wakeup_id) {
+      if (timestamp) {
+        *timestamp = shared->wakeups[i].at;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+static WakeupEntry *next_wakeup(void) {
+  WakeupEntry *next = NULL;
+  for (int i = 0; i < HOST_WAKEUPS; i++) {
+    WakeupEntry *entry = &shared->wakeups[i];
+    if (entry->id && (!next || entry->at < next->at)) {
+      next = entry;
+    }
+  }
+  return next;
+}
+
+// Layers
+
+typedef struct ClickHandlers {
+  ClickHandler single;
+  ClickHandler long_down;
+} ClickHandlers;
+
+struct Layer {
+  GRect frame;
+  GRect bounds;
+  Layer *parent;
+  Layer *children;
+  Layer *next;
+  bool hidden;
+  LayerUpdateProc update_proc;
+  void *data;
+};
+
+struct Window {
+  Layer root;
+  WindowHandlers handlers;
+  ClickConfigProvider click_provider;
+  void *click_context;
+  ClickHandlers clicks[NUM_BUTTONS];
+  GColor background;
+  bool is_loaded;
+};
+
+struct BitmapLayer {
+  Layer layer;
+  const GBitmap *bitmap;
+  GCompOp mode;
+};
+
+struct TextLayer {
+  Layer layer;
+  const char *text;
+  GFont font;
+  GTextAlignment alignment;
+  GTextOverflowMode overflow;
+  GColor text_color;
+  GColor background;
+};
+
+struct MenuLayer {
+  Layer layer;
+  MenuLayerCallbacks callbacks;
+  void *context;
+  MenuIndex selected;
+  GColor normal_background;
+  GColor normal_foreground;
+  GColor highlight_background;
+  GColor highlight_foreground;
+};
+
+struct ActionBarLayer {
+  Layer layer;
+  const GBitmap *icons[NUM_BUTTONS];
+  ClickConfigProvider click_provider;
+  GColor background;
+};
+
+// The whole window is redrawn whenever anything on it changed, as on the watch
+static bool is_dirty;
+
+static void init_layer(Layer *layer, GRect frame) {
+  *layer = (Layer) {
+    .frame = frame,
+    .bounds = { GPointZero, frame.size }
+  };
+}
+
+Layer *layer_create(GRect frame) {
+  return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+  Layer *layer = malloc(sizeof(Layer));
+  init_layer(layer, frame);
+  layer->data = data_size ? calloc(1, data_size) : NULL;
+  return layer;
+}
+
+static void detach_layer(Layer *layer) {
+  layer_remove_from_parent(layer);
+  for (Layer *child = layer->children; child; ) {
+    Layer *next = child->next;
+    child->parent = NULL;
+    child->next = NULL;
+    child = next;
+  }
+  layer->children = NULL;
+}
+
+void layer_destroy(Layer *layer) {
+  if (!layer) {
+    return;
+  }
+  detach_layer(layer);
+  free(layer->data);
+  free(layer);
+}
+
+void *layer_get_data(const Layer *layer) {
+  return layer->data;
+}
+
+void layer_mark_dirty(Layer *layer) {
+  is_dirty = true;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  layer->frame = frame;
+  layer->bounds.size = frame.size;
+  is_dirty = true;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return layer->bounds;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  layer_remove_from_parent(child);
+  child->parent = parent;
+  Layer **last = &parent->children;
+  while (*last) {
+    last = &(*last)->next;
+  }
+  *last = child;
+  is_dirty = true;
+}
+
+void layer_remove_from_parent(Layer *layer) {
+  if (!layer->parent) {
+    return;
+  }
+  for (Layer **link = &layer->parent->children; *link; link = &(*link)->next) {
+    if (*link == layer) {
+      *link = layer->next;
+      break;
+    }
+  }
+  layer->parent = NULL;
+  layer->next = NULL;
+  is_dirty = true;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  layer->hidden = hidden;
+  is_dirty = true;
+}
+
+bool layer_get_hidden(const Layer *layer) {
+  return layer->hidden;
+}
+
+GPoint layer_convert_point_to_screen(const Layer *layer, GPoint point) {
+  for (; layer; layer = layer->parent) {
+    point.x += layer->frame.origin.x + layer->bounds.origin.x;
+    point.y += layer->frame.origin.y + layer->bounds.origin.y;
+  }
+  return point;
+}
+
+// Bitmap layers center their bitmap, as the SDK does by default
+static void draw_bitmap_layer(Layer *layer, GContext *ctx) {
+  BitmapLayer *bitmap_layer = (BitmapLayer *) layer;
+  if (!bitmap_layer->bitmap) {
+    return;
+  }
+  GSize size = gbitmap_get_bounds(bitmap_layer->bitmap).size;
+  GRect rect = GRect((layer->bounds.size.w - size.w) / 2, (layer->bounds.size.h - size.h) / 2, size.w, size.h);
+  graphics_context_set_compositing_mode(ctx, bitmap_layer->mode);
+  graphics_draw_bitmap_in_rect(ctx, bitmap_layer->bitmap, rect);
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame) {
+  BitmapLayer *bitmap_layer = calloc(1, sizeof(BitmapLayer));
+  init_layer(&bitmap_layer->layer, frame);
+  bitmap_layer->layer.update_proc = draw_bitmap_layer;
+  return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer) {
+  detach_layer(&bitmap_layer->layer);
+  free(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer) {
+  return (Layer *) &bitmap_layer->layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap) {
+  bitmap_layer->bitmap = bitmap;
+  is_dirty = true;
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode) {
+  bitmap_layer->mode = mode;
+  is_dirty = true;
+}
+
+static void draw_text_layer(Layer *layer, GContext *ctx) {
+  TextLayer *text_layer = (TextLayer *) layer;
+  if (text_layer->background.a) {
+    graphics_context_set_fill_color(ctx, text_layer->background);
+    graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+  }
+  if (text_layer->text && text_layer->font) {
+    graphics_context_set_text_color(ctx, text_layer->text_color);
+    graphics_draw_text(ctx, text_layer->text, text_layer->font, layer->bounds, text_layer->overflow,
+                       text_layer->alignment, NULL);
+  }
+}
+
+TextLayer *text_layer_create(GRect frame) {
+  TextLayer *text_layer = calloc(1, sizeof(TextLayer));
+  init_layer(&text_layer->layer, frame);
+  text_layer->layer.update_proc = draw_text_layer;
+  text_layer->text_color = GColorBlack;
+  text_layer->background = GColorWhite;
+  text_layer->font = fonts_get_system_font(FONT_KEY_GOTHIC_18);
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  detach_layer(&text_layer->layer);
+  free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+  return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  text_layer->text = text;
+  is_dirty = true;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+  text_layer->font = font;
+  is_dirty = true;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment alignment) {
+  text_layer->alignment = alignment;
+  is_dirty = true;
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode mode) {
+  text_layer->overflow = mode;
+  is_dirty = true;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+  text_layer->text_color = color;
+  is_dirty = true;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+  text_layer->background = color;
+  is_dirty = true;
+}
+
+// Menus draw their rows through the app callbacks into cell sized layers
+
+static uint16_t menu_rows(MenuLayer *menu, uint16_t section) {
+  return menu->callbacks.get_num_rows ? menu->callbacks.get_num_rows(menu, section, menu->context) : 0;
+}
+
+static uint16_t menu_sections(MenuLayer *menu) {
+  return menu->callbacks.get_num_sections ? menu->callbacks.get_num_sections(menu, menu->context) : 1;
+}
+
+static void draw_menu_layer(Layer *layer, GContext *ctx) {
+  MenuLayer *menu = (MenuLayer *) layer;
+  GPoint origin = layer_convert_point_to_screen(layer, GPointZero);
+  GRect clip = { origin, layer->bounds.size };
+  int y = 0;
+  for (uint16_t section = 0; section < menu_sections(menu) && y < layer->bounds.size.h; section++) {
+    int header_height = menu->callbacks.get_header_height ?
+      menu->callbacks.get_header_height(menu, section, menu->context) : 0;
+    Layer cell;
+    if (header_height && menu->callbacks.draw_header) {
+      init_layer(&cell, GRect(0, y, layer->bounds.size.w, header_height));
+      host_graphics_layer_begin(ctx, GPoint(origin.x, origin.y + y), clip);
+      graphics_context_set_fill_color(ctx, menu->normal_background);
+      graphics_fill_rect(ctx, cell.bounds, 0, GCornerNone);
+      graphics_context_set_text_color(ctx, menu->normal_foreground);
+      menu->callbacks.draw_header(ctx, &cell, section, menu->context);
+      y += header_height;
+    }
+    for (uint16_t row = 0; row < menu_rows(menu, section) && y < layer->bounds.size.h; row++) {
+      bool is_selected = menu->selected.section == section && menu->selected.row == row;
+      MenuIndex index = { section, row };
+      init_layer(&cell, GRect(0, y, layer->bounds.size.w, MENU_CELL_HEIGHT));
+      host_graphics_layer_begin(ctx, GPoint(origin.x, origin.y + y), clip);
+      graphics_context_set_fill_color(ctx, is_selected ? menu->highlight_background : menu->normal_background);
+      graphics_fill_rect(ctx, cell.bounds, 0, GCornerNone);
+      graphics_context_set_text_color(ctx, is_selected ? menu->highlight_foreground : menu->normal_foreground);
+      if (menu->callbacks.draw_row) {
+        menu->callbacks.draw_row(ctx, &cell, &index, menu->context);
+      }
+      y += MENU_CELL_HEIGHT;
+    }
+  }
+}
+
+MenuLayer *menu_layer_create(GRect frame) {
+  MenuLayer *menu = calloc(1, sizeof(MenuLayer));
+  init_layer(&menu->layer, frame);
+  menu->layer.update_proc = draw_menu_layer;
+  menu->normal_background = GColorWhite;
+  menu->normal_foreground = GColorBlack;
+  menu->highlight_background = GColorBlack;
+  menu->highlight_foreground = GColorWhite;
+  return menu;
+}
+
+void menu_layer_destroy(MenuLayer *menu) {
+  detach_layer(&menu->layer);
+  free(menu);
+}
+
+void menu_layer_set_callbacks(MenuLayer *menu, void *context, MenuLayerCallbacks callbacks) {
+  menu->callbacks = callbacks;
+  menu->context = context;
+  is_dirty = true;
+}
+
+static void menu_step(MenuLayer *menu, int step) {
+  MenuIndex index = menu->selected;
+  if (step > 0 && index.row + 1 < menu_rows(menu, index.section)) {
+    index.row++;
+  } else if (step > 0 && index.section + 1 < menu_sections(menu)) {
+    index = (MenuIndex) { index.section + 1, 0 };
+  } else if (step < 0 && index.row > 0) {
+    index.row--;
+  } else if (step < 0 && index.section > 0) {
+    index.section--;
+    index.row = MAX(menu_rows(menu, index.section), 1) - 1;
+  }
+  menu->selected = index;
+  is_dirty = true;
+}
+
+static void menu_up_handler(ClickRecognizerRef recognizer, void *context) {
+  menu_step(context, -1);
+}
+
+static void menu_down_handler(ClickRecognizerRef recognizer, void *context) {
+  menu_step(context, 1);
+}
+
+static void menu_select_handler(ClickRecognizerRef recognizer, void *context) {
+  MenuLayer *menu = context;
+  if (menu->callbacks.select_click) {
+    menu->callbacks.select_click(menu, &menu->selected, menu->context);
+  }
+}
+
+static void menu_click_config(void *context) {
+  window_single_click_subscribe(BUTTON_ID_UP, menu_up_handler);
+  window_single_click_subscribe(BUTTON_ID_DOWN, menu_down_handler);
+  window_single_click_subscribe(BUTTON_ID_SELECT, menu_select_handler);
+}
+
+void menu_layer_set_click_config_onto_window(MenuLayer *menu, Window *window) {
+  window->click_provider = menu_click_config;
+  window->click_context = menu;
+}
+
+void menu_layer_set_normal_colors(MenuLayer *menu, GColor background, GColor foreground) {
+  menu->normal_background = background;
+  menu->normal_foreground = foreground;
+}
+
+void menu_layer_set_highlight_colors(MenuLayer *menu, GColor background, GColor foreground) {
+  menu->highlight_background = background;
+  menu->highlight_foreground = foreground;
+}
+
+void menu_layer_set_selected_index(MenuLayer *menu, MenuIndex index, MenuRowAlign align, bool animated) {
+  menu->selected = index;
+  is_dirty = true;
+}
+
+void menu_layer_reload_data(MenuLayer *menu) {
+  is_dirty = true;
+}
+
+#define ACTION_BAR_WIDTH PBL_IF_ROUND_ELSE(40, 30)
+
+static void draw_action_bar(Layer *layer, GContext *ctx) {
+  ActionBarLayer *action_bar = (ActionBarLayer *) layer;
+  graphics_context_set_fill_color(ctx, action_bar->background);
+  graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+  graphics_context_set_compositing_mode(ctx, GCompOpSet);
+  for (int button = BUTTON_ID_UP; button < NUM_BUTTONS; button++) {
+    const GBitmap *icon = action_bar->icons[button];
+    if (icon) {
+      GSize size = gbitmap_get_bounds(icon).size;
+      int center_y = layer->bounds.size.h * (button - BUTTON_ID_UP + 1) / 4;
+      graphics_draw_bitmap_in_rect(ctx, icon, GRect((ACTION_BAR_WIDTH - size.w) / 2, center_y - size.h / 2,
+                                                    size.w, size.h));
+    }
+  }
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+ActionBarLayer *action_bar_layer_create(void) {
+  ActionBarLayer *action_bar = calloc(1, sizeof(ActionBarLayer));
+  init_layer(&action_bar->layer, GRect(HOST_SCREEN_WIDTH - ACTION_BAR_WIDTH, 0, ACTION_BAR_WIDTH, HOST_SCREEN_HEIGHT));
+  action_bar->layer.update_proc = draw_action_bar;
+  action_bar->background = GColorBlack;
+  return action_bar;
+}
+
+void action_bar_layer_destroy(ActionBarLayer *action_bar) {
+  detach_layer(&action_bar->layer);
+  free(action_bar);
+}
+
+// The action bar takes over the window's buttons
+void action_bar_layer_add_to_window(ActionBarLayer *action_bar, Window *window) {
+  layer_add_child(&window->root, &action_bar->layer);
+  window->click_provider = action_bar->click_provider;
+  window->click_context = action_bar;
+}
+
+void action_bar_layer_set_background_color(ActionBarLayer *action_bar, GColor color) {
+  action_bar->background = color;
+  is_dirty = true;
+}
+
+void action_bar_layer_set_icon(ActionBarLayer *action_bar, ButtonId button_id, const GBitmap *icon) {
+  action_bar->icons[button_id] = icon;
+  is_dirty = true;
+}
+
+void action_bar_layer_set_click_config_provider(ActionBarLayer *action_bar, ClickConfigProvider provider) {
+  action_bar->click_provider = provider;
+  Layer *root = action_bar->layer.parent;
+  if (root) {
+    Window *window = (Window *) root;
+    window->click_provider = provider;
+    window->click_context = action_bar;
+  }
+}
+
+// Windows
+
+static Window *stack[HOST_WINDOWS];
+static int stack_size;
+static Window *configuring;
+
+static Window *top_window(void) {
+  return stack_size ? stack[stack_size - 1] : NULL;
+}
+
+Window *window_create(void) {
+  Window *window = calloc(1, sizeof(Window));
+  init_layer(&window->root, GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT));
+  window->background = GColorWhite;
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (!window) {
+    return;
+  }
+  window_stack_remove(window, false);
+  detach_layer(&window->root);
+  free(window);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *) &window->root;
+}
+
+void window_set_background_color(Window *window, GColor color) {
+  window->background = color;
+  is_dirty = true;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider provider) {
+  window->click_provider = provider;
+  window->click_context = window;
+}
+
+void window_single_click_subscribe(ButtonId button, ClickHandler handler) {
+  configuring->clicks[button].single = handler;
+}
+
+void window_single_repeating_click_subscribe(ButtonId button, uint16_t repeat_interval_ms, ClickHandler handler) {
+  configuring->clicks[button].single = handler;
+}
+
+void window_long_click_subscribe(ButtonId button, uint16_t delay_ms, ClickHandler down_handler,
+                                 ClickHandler up_handler) {
+  configuring->clicks[button].long_down = down_handler;
+}
+
+// Buttons are configured whenever a window comes to the top
+static void configure_clicks(Window *window) {
+  memset(window->clicks, 0, sizeof(window->clicks));
+  if (window->click_provider) {
+    configuring = window;
+    window->click_provider(window->click_context);
+    configuring = NULL;
+  }
+}
+
+static void show_top_window(void) {
+  Window *window = top_window();
+  if (!window) {
+    return;
+  }
+  configure_clicks(window);
+  is_dirty = true;
+  if (window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+}
+
+static void unload_window(Window *window) {
+  window->is_loaded = false;
+  if (window->handlers.unload) {
+    window->handlers.unload(window);
+  }
+}
+
+void window_stack_push(Window *window, bool animated) {
+  Window *previous = top_window();
+  if (previous == window || stack_size == HOST_WINDOWS) {
+    return;
+  }
+  stack[stack_size++] = window;
+  if (!window->is_loaded) {
+    window->is_loaded = true;
+    if (window->handlers.load) {
+      window->handlers.load(window);
+    }
+  }
+  if (previous && previous->handlers.disappear) {
+    previous->handlers.disappear(previous);
+  }
+  show_top_window();
+}
+
+bool window_stack_remove(Window *window, bool animated) {
+  int index = stack_size - 1;
+  while (index >= 0 && stack[index] != window) {
+    index--;
+  }
+  if (index < 0) {
+    return false;
+  }
+  bool was_top = index == stack_size - 1;
+  if (was_top && window->handlers.disappear) {
+    window->handlers.disappear(window);
+  }
+  memmove(&stack[index], &stack[index + 1], (stack_size - index - 1) * sizeof(Window *));
+  stack_size--;
+  unload_window(window);
+  if (was_top) {
+    show_top_window();
+  }
+  return true;
+}
+
+void window_stack_pop_all(bool animated) {
+  Window *window = top_window();
+  if (window && window->handlers.disappear) {
+    window->handlers.disappear(window);
+  }
+  while (stack_size) {
+    unload_window(stack[--stack_size]);
+  }
+}
+
+// Rendering, the layers are drawn parent first and clipped to every ancestor
+
+static GRect intersect(GRect a, GRect b) {
+  int x0 = MAX(a.origin.x, b.origin.x);
+  int y0 = MAX(a.origin.y, b.origin.y);
+  int x1 = MIN(a.origin.x + a.size.w, b.origin.x + b.size.w);
+  int y1 = MIN(a.origin.y + a.size.h, b.origin.y + b.size.h);
+  return GRect(x0, y0, MAX(x1 - x0, 0), MAX(y1 - y0, 0));
+}
+
+static void draw_layer(GContext *ctx, Layer *layer, GPoint parent_origin, GRect parent_clip) {
+  if (layer->hidden) {
+    return;
+  }
+  GPoint origin = GPoint(parent_origin.x + layer->frame.origin.x, parent_origin.y + layer->frame.origin.y);
+  GRect clip = intersect(parent_clip, (GRect) { origin, layer->frame.size });
+  if (clip.size.w == 0 || clip.size.h == 0) {
+    return;
+  }
+  origin.x += layer->bounds.origin.x;
+  origin.y += layer->bounds.origin.y;
+  if (layer->update_proc) {
+    host_graphics_layer_begin(ctx, origin, clip);
+    layer->update_proc(layer, ctx);
+  }
+  for (Layer *child = layer->children; child; child = child->next) {
+    draw_layer(ctx, child, origin, clip);
+  }
+}
+
+static void write_capture(void) {
+  if (capture_index >= capture_frames) {
+    return;
+  }
+  char name[32];
+  if (capture_frames == 1) {
+    snprintf(name, sizeof(name), "%s", capture_name);
+  } else {
+    snprintf(name, sizeof(name), "%s-%02d", capture_name, capture_index);
+  }
+  capture_index++;
+  host_graphics_write_frame(name);
+}
+
+static void render(void) {
+  Window *window = top_window();
+  if (!window || !is_dirty) {
+    return;
+  }
+  is_dirty = false;
+  COUNT(redraws, 1);
+  GContext *ctx = host_graphics_frame_begin(window->background);
+  draw_layer(ctx, &window->root, GPointZero, GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT));
+  host_graphics_frame_end(ctx);
+  write_capture();
+}
+
+// Animations advance one frame every HOST_FRAME_MS while scheduled
+
+struct Animation {
+  bool is_used;
+  bool is_scheduled;
+  uint32_t duration_ms;
+  int64_t start_ms;
+  int64_t next_frame_ms;
+  AnimationImplementation implementation;
+  AnimationHandlers handlers;
+  void *context;
+  // property animations only
+  Layer *layer;
+  GRect from_frame;
+  GRect to_frame;
+};
+
+static Animation animations[HOST_ANIMATIONS];
+
+Animation *animation_create(void) {
+  for (int i = 0; i < HOST_ANIMATIONS; i++) {
+    if (!animations[i].is_used) {
+      animations[i] = (Animation) { .is_used = true, .duration_ms = DEFAULT_ANIMATION_MS };
+      return &animations[i];
+    }
+  }
+  fprintf(stderr, "out of animations\n");
+  exit(1);
+}
+
+bool animation_destroy(Animation *animation) {
+  animation->is_used = false;
+  animation->is_scheduled = false;
+  return true;
+}
+
+bool animation_set_duration(Animation *animation, uint32_t duration_ms) {
+  animation->duration_ms = duration_ms;
+  return true;
+}
+
+bool animation_set_elapsed(Animation *animation, uint32_t elapsed_ms) {
+  animation->start_ms = shared->clock_ms - elapsed_ms;
+  animation->next_frame_ms = shared->clock_ms + HOST_FRAME_MS;
+  return true;
+}
+
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation) {
+  animation->implementation = *implementation;
+  return true;
+}
+
+bool animation_set_handlers(Animation *animation, AnimationHandlers handlers, void *context) {
+  animation->handlers = handlers;
+  animation->context = context;
+  return true;
+}
+
+bool animation_schedule(Animation *animation) {
+  animation->is_scheduled = true;
+  animation->start_ms = shared->clock_ms;
+  animation->next_frame_ms = shared->clock_ms + HOST_FRAME_MS;
+  if (animation->implementation.setup) {
+    animation->implementation.setup(animation);
+  }
+  if (animation->handlers.started) {
+    animation->handlers.started(animation, animation->context);
+  }
+  return true;
+}
+
+bool animation_unschedule(Animation *animation) {
+  if (!animation->is_scheduled) {
+    return false;
+  }
+  animation->is_scheduled = false;
+  if (animation->handlers.stopped) {
+    animation->handlers.stopped(animation, false, animation->context);
+  }
+  return true;
+}
+
+static int16_t interpolate(int16_t from, int16_t to, AnimationProgress progress) {
+  return from + (to - from) * (int32_t) progress / ANIMATION_NORMALIZED_MAX;
+}
+
+static void update_layer_frame(Animation *animation, const AnimationProgress progress) {
+  GRect from = animation->from_frame;
+  GRect to = animation->to_frame;
+  layer_set_frame(animation->layer, GRect(interpolate(from.origin.x, to.origin.x, progress),
+                                          interpolate(from.origin.y, to.origin.y, progress),
+                                          interpolate(from.size.w, to.size.w, progress),
+                                          interpolate(from.size.h, to.size.h, progress)));
+}
+
+PropertyAnimation *property_animation_create_layer_frame(Layer *layer, GRect *from_frame, GRect *to_frame) {
+  Animation *animation = animation_create();
+  animation->layer = layer;
+  animation->from_frame = from_frame ? *from_frame : layer_get_frame(layer);
+  animation->to_frame = to_frame ? *to_frame : layer_get_frame(layer);
+  animation->implementation = (AnimationImplementation) { .update = update_layer_frame };
+  return animation;
+}
+
+void property_animation_destroy(PropertyAnimation *property_animation) {
+  animation_destroy(property_animation);
+}
+
+static Animation *next_animation(void) {
+  Animation *next = NULL;
+  for (int i = 0; i < HOST_ANIMATIONS; i++) {
+    Animation *animation = &animations[i];
+    if (animation->is_scheduled && (!next || animation->next_frame_ms < next->next_frame_ms)) {
+      next = animation;
+    }
+  }
+  return next;
+}
+
+static void animation_frame(Animation *animation) {
+  int64_t elapsed = shared->clock_ms - animation->start_ms;
+  bool is_finished = elapsed >= animation->duration_ms;
+  AnimationProgress progress = is_finished ? ANIMATION_NORMALIZED_MAX :
+    (AnimationProgress) (elapsed * ANIMATION_NORMALIZED_MAX / animation->duration_ms);
+  if (animation->implementation.update) {
+    animation->implementation.update(animation, progress);
+  }
+  if (!is_finished) {
+    animation->next_frame_ms += HOST_FRAME_MS;
+    return;
+  }
+  animation->is_scheduled = false;
+  if (animation->implementation.teardown) {
+    animation->implementation.teardown(animation);
+  }
+  if (animation->handlers.stopped) {
+    animation->handlers.stopped(animation, true, animation->context);
+  }
+}
+
+// Event loop, the clock jumps straight to whatever is due next
+
+static int64_t action_time(size_t index) {
+  return MAX(actions[index].at * (int64_t) 1000, input_floor_ms);
+}
+
+// Phone actions also run while the app is closed, there is no handler then
+static void perform_phone_action(const HostAction *action) {
+  switch (action->type) {
+    case HOST_PHONE_CONNECT:
+    case HOST_PHONE_DISCONNECT:
+      shared->is_phone_connected = action->type == HOST_PHONE_CONNECT;
+      if (connection_handlers.pebble_app_connection_handler) {
+        connection_handlers.pebble_app_connection_handler(connection_service_peek_pebble_app_connection());
+      }
+      break;
+    case HOST_PHONE_CLEAR:
+      host_phone_event("{\"event\": \"clear\"}", NULL, NULL);
+      break;
+    default:
+      break;
+  }
+}
+
+static void perform_action(const HostAction *action) {
+  Window *window = top_window();
+  switch (action->type) {
+    case HOST_LAUNCH:
+      return;
+    case HOST_CLICK: {
+      ClickHandler handler = window->clicks[action->button].single;
+      if (handler) {
+        handler(NULL, window->click_context);
+      } else if (action->button == BUTTON_ID_BACK) {
+        window_stack_remove(window, true);
+      }
+      break;
+    }
+    case HOST_LONG_CLICK: {
+      ClickHandler handler = window->clicks[action->button].long_down;
+      if (handler) {
+        handler(NULL, window->click_context);
+      }
+      break;
+    }
+    case HOST_FOCUS_LOST:
+    case HOST_FOCUS_GAINED: {
+      bool in_focus = action->type == HOST_FOCUS_GAINED;
+      if (focus_handlers.will_focus) {
+        focus_handlers.will_focus(in_focus);
+      }
+      if (focus_handlers.did_focus) {
+        focus_handlers.did_focus(in_focus);
+      }
+      break;
+    }
+    case HOST_CAPTURE:
+      capture_name = action->name;
+      capture_frames = MAX(action->frames, 1);
+      capture_index = 0;
+      write_capture();
+      break;
+    case HOST_PHONE_CONNECT:
+    case HOST_PHONE_DISCONNECT:
+    case HOST_PHONE_CLEAR:
+      perform_phone_action(action);
+      break;
+  }
+}
+
+typedef enum Event {
+  EVENT_END,
+  EVENT_TIMER,
+  EVENT_TICK,
+  EVENT_ANIMATION,
+  EVENT_MESSAGE,
+  EVENT_ACTION
+} Event;
+
+void app_event_loop(void) {
+  render();
+  while (top_window()) {
+    Event event = EVENT_END;
+    int64_t at = until_ms;
+    AppTimer *timer = next_timer();
+    if (timer && timer->due_ms < at) {
+      event = EVENT_TIMER;
+      at = timer->due_ms;
+    }
+    if (tick_handler && next_tick_ms < at) {
+      event = EVENT_TICK;
+      at = next_tick_ms;
+    }
+    Animation *animation = next_animation();
+    if (animation && animation->next_frame_ms < at) {
+      event = EVENT_ANIMATION;
+      at = animation->next_frame_ms;
+    }
+    InboxMessage *message = next_inbox_message();
+    if (message && message->due_ms < at) {
+      event = EVENT_MESSAGE;
+      at = message->due_ms;
+    }
+    if (shared->next_action < action_count && action_time(shared->next_action) < at) {
+      event = EVENT_ACTION;
+      at = action_time(shared->next_action);
+    }
+
+    advance_to(at);
+    if (event == EVENT_END) {
+      window_stack_pop_all(false);
+      break;
+    }
+    COUNT(wakeups, 1);
+    switch (event) {
+      case EVENT_TIMER:
+        timer->is_pending = false;
+        timer->callback(timer->data);
+        break;
+      case EVENT_TICK: {
+        next_tick_ms += tick_period() * 1000;
+        time_t now = host_now();
+        tick_handler(localtime(&now), tick_units);
+        break;
+      }
+      case EVENT_ANIMATION:
+        animation_frame(animation);
+        break;
+      case EVENT_MESSAGE:
+        deliver_inbox_message(message);
+        break;
+      case EVENT_ACTION:
+        perform_action(&actions[shared->next_action++]);
+        break;
+      case EVENT_END:
+        break;
+    }
+    render();
+  }
+}
+
+// Launches
+
+void host_init(time_t now) {
+  if (!shared) {
+    shared = mmap(NULL, sizeof(HostShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+      perror("mmap");
+      exit(1);
+    }
+  }
+  memset(shared, 0, sizeof(HostShared));
+  shared->clock_ms = now * (int64_t) 1000;
+}
+
+const HostStats *host_stats(void) {
+  return &shared->stats;
+}
+
+const HostStats *host_hour_stats(int hour) {
+  return &shared->hours[hour % 24];
+}
+
+static void launch(AppLaunchReason launch_reason, time_t until) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if (pid == 0) {
+    reason = launch_reason;
+    until_ms = until * (int64_t) 1000;
+    input_floor_ms = shared->clock_ms + HOST_INPUT_DELAY_MS;
+    COUNT(launches, 1);
+    COUNT(wakeups, 1);
+    // PebbleKit JS starts with the watchapp and greets it
+    if (connection_service_peek_pebble_app_connection()) {
+      tell_phone("{\"event\": \"ready\"}", HOST_PHONE_LATENCY_MS);
+    }
+    app_main();
+    fflush(stdout);
+    _exit(0);
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "app crashed at %ld\n", (long) host_now());
+    exit(1);
+  }
+}
+
+void host_run(const HostAction *run_actions, size_t run_action_count, time_t until) {
+  actions = run_actions;
+  action_count = run_action_count;
+  while (host_now() < until) {
+    WakeupEntry *wakeup = next_wakeup();
+    // notifications and captures while the app is closed do not concern it, the phone goes on
+    while (shared->next_action < action_count && actions[shared->next_action].type >= HOST_FOCUS_LOST &&
+           (!wakeup || actions[shared->next_action].at < wakeup->at)) {
+      const HostAction *action = &actions[shared->next_action++];
+      if (action->type >= HOST_PHONE_CONNECT && action->at < until) {
+        advance_to(action->at * (int64_t) 1000);
+        perform_phone_action(action);
+      }
+    }
+    bool has_action = shared->next_action < action_count;
+    time_t action_at = has_action ? actions[shared->next_action].at : until;
+    if (wakeup && wakeup->at <= action_at && wakeup->at < until) {
+      advance_to(wakeup->at * (int64_t) 1000);
+      wakeup->id = 0;
+      launch(APP_LAUNCH_WAKEUP, until);
+    } else if (has_action && action_at < until) {
+      advance_to(action_at * (int64_t) 1000);
+      launch(APP_LAUNCH_USER, until);
+    } else {
+      advance_to(until * (int64_t) 1000);
+    }
+  }
+}
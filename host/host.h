@@ -0,0 +1,116 @@
+#include <pebble.h>
+
+#ifndef HOST_H
+#define HOST_H
+
+// The platform is picked at compile time, see HOST_PLATFORMS in wscript
+#ifdef PBL_ROUND
+#define HOST_SCREEN_WIDTH 180
+#define HOST_SCREEN_HEIGHT 180
+#else
+#define HOST_SCREEN_WIDTH 144
+#define HOST_SCREEN_HEIGHT 168
+#endif
+
+#ifdef PBL_COLOR
+#define HOST_HEAP_SIZE (64 * 1024)
+#else
+#define HOST_HEAP_SIZE (24 * 1024)
+#endif
+
+// tomato.c's main(), renamed by the host build
+int app_main(void);
+
+typedef enum HostActionType {
+  // opens the app if it is closed, nothing else
+  HOST_LAUNCH,
+  HOST_CLICK,
+  HOST_LONG_CLICK,
+  // the rest is ignored while the app is closed
+  // a notification covering the app and going away again
+  HOST_FOCUS_LOST,
+  HOST_FOCUS_GAINED,
+  // writes the frame on screen and the frames - 1 drawn after it, see host_graphics_write_frame()
+  HOST_CAPTURE,
+  // the phone's own, they happen whether the app is open or not
+  HOST_PHONE_CONNECT,
+  HOST_PHONE_DISCONNECT,
+  // the phone app is reinstalled and forgets what it stored
+  HOST_PHONE_CLEAR
+} HostActionType;
+
+// Input at a simulated time. Clicks while the app is closed launch it and
+// arrive a second later, once the first frame is up.
+typedef struct HostAction {
+  time_t at;
+  HostActionType type;
+  ButtonId button;
+  const char *name;
+  int frames;
+} HostAction;
+
+// What the simulated OS saw the app do
+typedef struct HostStats {
+  uint32_t launches;
+  // launches, timer callbacks, ticks, animation frames and input the app handled
+  uint32_t wakeups;
+  uint32_t redraws;
+  uint32_t persist_writes;
+  uint32_t persist_bytes;
+  uint32_t vibes;
+} HostStats;
+
+// Resets the clock, storage and counters
+void host_init(time_t now);
+
+time_t host_now(void);
+
+// Plays the actions against the app until the clock reaches until. The app
+// is launched by user input and by the wakeups it schedules, each launch
+// runs in a child process so it starts from fresh statics as on the watch.
+void host_run(const HostAction *actions, size_t action_count, time_t until);
+
+const HostStats *host_stats(void);
+
+// The share of the counters that fell into an hour of the UTC day
+const HostStats *host_hour_stats(int hour);
+
+// Starts the phone stand-in, a PebbleKit JS runner such as host/phone.js.
+// Without one the phone stays out of reach.
+void host_phone_open(char *const command[]);
+
+typedef void (*HostPhoneReply)(const char *line, void *context);
+
+// Writes one event line to the phone and hands each line it answers to reply
+void host_phone_event(const char *event, HostPhoneReply reply, void *context);
+
+// Resources of the platform, generated by wscript from appinfo.json
+typedef enum HostResourceType {
+  HOST_RESOURCE_NONE,
+  HOST_RESOURCE_BITMAP,
+  HOST_RESOURCE_FONT
+} HostResourceType;
+
+typedef struct HostResource {
+  HostResourceType type;
+  GSize size;
+  GBitmapFormat format;
+  uint16_t row_size;
+  const uint8_t *data;
+  const GColor *palette;
+  int font_height;
+} HostResource;
+
+extern const HostResource host_resources[];
+extern const size_t host_resource_count;
+
+// Between fake_pebble.c, which walks the layers, and fake_graphics.c
+GContext *host_graphics_frame_begin(GColor background);
+void host_graphics_layer_begin(GContext *ctx, GPoint origin, GRect clip);
+void host_graphics_frame_end(GContext *ctx);
+// Appends the last frame drawn, with what drawing it cost, to frames.raw in
+// the working directory, read by wscript `sweep`
+void host_graphics_write_frame(const char *name);
+void host_heap_add(int bytes);
+
+#endif /* HOST_H */
@@ -0,0 +1,481 @@
+// Stand-in for the Pebble SDK header, only what the app uses. Implemented by
+// host/fake_pebble.c and host/fake_graphics.c, see wscript `host`.
+#ifndef PEBBLE_H
+#define PEBBLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "resource_ids.auto.h"
+
+// Simulated clock
+time_t host_time(time_t *t);
+#define time(t) host_time(t)
+uint16_t time_ms(time_t *t, uint16_t *ms);
+
+#define PBL_SDK_3 1
+#ifdef PBL_COLOR
+#define PBL_IF_COLOR_ELSE(a, b) (a)
+#else
+#define PBL_BW 1
+#define PBL_IF_COLOR_ELSE(a, b) (b)
+#endif
+#ifdef PBL_ROUND
+#define PBL_IF_ROUND_ELSE(a, b) (a)
+#else
+#define PBL_RECT 1
+#define PBL_IF_ROUND_ELSE(a, b) (b)
+#endif
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define ARRAY_LENGTH(a) (sizeof(a) / sizeof((a)[0]))
+
+#define SECONDS_PER_MINUTE 60
+#define SECONDS_PER_HOUR 3600
+#define SECONDS_PER_DAY 86400
+
+// Logging
+
+enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200
+};
+void app_log(uint8_t level, const char *file, int line, const char *fmt, ...);
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// Geometry and color
+
+typedef struct GPoint { int16_t x, y; } GPoint;
+typedef struct GSize { int16_t w, h; } GSize;
+typedef struct GRect { GPoint origin; GSize size; } GRect;
+#define GPoint(x, y) ((GPoint) { (x), (y) })
+#define GSize(w, h) ((GSize) { (w), (h) })
+#define GRect(x, y, w, h) ((GRect) { { (x), (y) }, { (w), (h) } })
+#define GPointZero GPoint(0, 0)
+
+typedef union GColor8 {
+  uint8_t argb;
+  struct {
+    uint8_t b : 2;
+    uint8_t g : 2;
+    uint8_t r : 2;
+    uint8_t a : 2;
+  };
+} GColor8;
+typedef GColor8 GColor;
+#define gcolor_equal(a, b) ((a).argb == (b).argb)
+
+#define GColorClearARGB8 ((uint8_t) 0x00)
+#define GColorBlackARGB8 ((uint8_t) 0xC0)
+#define GColorDukeBlueARGB8 ((uint8_t) 0xC2)
+#define GColorDarkGrayARGB8 ((uint8_t) 0xD5)
+#define GColorLightGrayARGB8 ((uint8_t) 0xEA)
+#define GColorWhiteARGB8 ((uint8_t) 0xFF)
+#define GColorClear ((GColor8) { .argb = GColorClearARGB8 })
+#define GColorBlack ((GColor8) { .argb = GColorBlackARGB8 })
+#define GColorDukeBlue ((GColor8) { .argb = GColorDukeBlueARGB8 })
+#define GColorDarkGray ((GColor8) { .argb = GColorDarkGrayARGB8 })
+#define GColorLightGray ((GColor8) { .argb = GColorLightGrayARGB8 })
+#define GColorWhite ((GColor8) { .argb = GColorWhiteARGB8 })
+
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+
+// Bitmaps, fonts and resources
+
+typedef struct GBitmap GBitmap;
+typedef struct HostFont *GFont;
+typedef const void *ResHandle;
+
+typedef enum {
+  GBitmapFormat1Bit,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+  GBitmapFormat8BitCircular
+} GBitmapFormat;
+
+typedef struct GBitmapDataRowInfo {
+  uint8_t *data;
+  int16_t min_x;
+  int16_t max_x;
+} GBitmapDataRowInfo;
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette,
+                                           bool free_on_destroy);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base, GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+GColor *gbitmap_get_palette(const GBitmap *bitmap);
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y);
+
+#define FONT_KEY_GOTHIC_18 "GOTHIC_18"
+#define FONT_KEY_GOTHIC_24_BOLD "GOTHIC_24_BOLD"
+GFont fonts_get_system_font(const char *font_key);
+GFont fonts_load_custom_font(ResHandle handle);
+void fonts_unload_custom_font(GFont font);
+ResHandle resource_get_handle(uint32_t resource_id);
+
+// Graphics
+
+typedef struct GContext GContext;
+
+typedef enum {
+  GCompOpAssign,
+  GCompOpAssignInverted,
+  GCompOpOr,
+  GCompOpAnd,
+  GCompOpClear,
+  GCompOpSet
+} GCompOp;
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight
+} GTextAlignment;
+
+typedef enum {
+  GTextOverflowModeWordWrap,
+  GTextOverflowModeTrailingEllipsis,
+  GTextOverflowModeFill
+} GTextOverflowMode;
+
+typedef enum { GCornerNone = 0 } GCornerMask;
+typedef struct GTextAttributes GTextAttributes;
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corners);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow, GTextAlignment alignment, GTextAttributes *attributes);
+GSize graphics_text_layout_get_content_size(const char *text, GFont font, GRect box,
+                                            GTextOverflowMode overflow, GTextAlignment alignment);
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+// Layers and windows
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef struct BitmapLayer BitmapLayer;
+typedef struct TextLayer TextLayer;
+typedef struct MenuLayer MenuLayer;
+typedef struct ActionBarLayer ActionBarLayer;
+
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+void layer_mark_dirty(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_bounds(const Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *layer);
+void layer_set_hidden(Layer *layer, bool hidden);
+bool layer_get_hidden(const Layer *layer);
+GPoint layer_convert_point_to_screen(const Layer *layer, GPoint point);
+
+BitmapLayer *bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer);
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap);
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode);
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment alignment);
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode mode);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+
+typedef enum {
+  BUTTON_ID_BACK,
+  BUTTON_ID_UP,
+  BUTTON_ID_SELECT,
+  BUTTON_ID_DOWN,
+  NUM_BUTTONS
+} ButtonId;
+
+typedef struct ClickRecognizer *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+typedef void (*WindowHandler)(Window *window);
+typedef struct WindowHandlers {
+  WindowHandler load;
+  WindowHandler appear;
+  WindowHandler disappear;
+  WindowHandler unload;
+} WindowHandlers;
+
+Window *window_create(void);
+void window_destroy(Window *window);
+Layer *window_get_root_layer(const Window *window);
+void window_set_background_color(Window *window, GColor color);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_click_config_provider(Window *window, ClickConfigProvider provider);
+void window_single_click_subscribe(ButtonId button, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button, uint16_t repeat_interval_ms, ClickHandler handler);
+void window_long_click_subscribe(ButtonId button, uint16_t delay_ms, ClickHandler down_handler,
+                                 ClickHandler up_handler);
+void window_stack_push(Window *window, bool animated);
+bool window_stack_remove(Window *window, bool animated);
+void window_stack_pop_all(bool animated);
+
+typedef struct MenuIndex {
+  uint16_t section;
+  uint16_t row;
+} MenuIndex;
+
+typedef enum {
+  MenuRowAlignNone,
+  MenuRowAlignCenter,
+  MenuRowAlignTop,
+  MenuRowAlignBottom
+} MenuRowAlign;
+
+#define MENU_CELL_BASIC_HEADER_HEIGHT 16
+
+typedef uint16_t (*MenuLayerGetNumberOfSectionsCallback)(MenuLayer *menu_layer, void *context);
+typedef uint16_t (*MenuLayerGetNumberOfRowsInSectionsCallback)(MenuLayer *menu_layer, uint16_t section_index,
+                                                               void *context);
+typedef int16_t (*MenuLayerGetHeaderHeightCallback)(MenuLayer *menu_layer, uint16_t section_index, void *context);
+typedef void (*MenuLayerDrawRowCallback)(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index,
+                                         void *context);
+typedef void (*MenuLayerDrawHeaderCallback)(GContext *ctx, const Layer *cell_layer, uint16_t section_index,
+                                            void *context);
+typedef void (*MenuLayerSelectCallback)(MenuLayer *menu_layer, MenuIndex *cell_index, void *context);
+
+typedef struct MenuLayerCallbacks {
+  MenuLayerGetNumberOfSectionsCallback get_num_sections;
+  MenuLayerGetNumberOfRowsInSectionsCallback get_num_rows;
+  MenuLayerGetHeaderHeightCallback get_header_height;
+  MenuLayerDrawRowCallback draw_row;
+  MenuLayerDrawHeaderCallback draw_header;
+  MenuLayerSelectCallback select_click;
+} MenuLayerCallbacks;
+
+MenuLayer *menu_layer_create(GRect frame);
+void menu_layer_destroy(MenuLayer *menu_layer);
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *context, MenuLayerCallbacks callbacks);
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window);
+void menu_layer_set_normal_colors(MenuLayer *menu_layer, GColor background, GColor foreground);
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground);
+void menu_layer_set_selected_index(MenuLayer *menu_layer, MenuIndex index, MenuRowAlign align, bool animated);
+void menu_layer_reload_data(MenuLayer *menu_layer);
+void menu_cell_basic_draw(GContext *ctx, const Layer *cell_layer, const char *title, const char *subtitle,
+                          GBitmap *icon);
+void menu_cell_basic_header_draw(GContext *ctx, const Layer *cell_layer, const char *title);
+
+ActionBarLayer *action_bar_layer_create(void);
+void action_bar_layer_destroy(ActionBarLayer *action_bar);
+void action_bar_layer_add_to_window(ActionBarLayer *action_bar, Window *window);
+void action_bar_layer_set_background_color(ActionBarLayer *action_bar, GColor color);
+void action_bar_layer_set_icon(ActionBarLayer *action_bar, ButtonId button_id, const GBitmap *icon);
+void action_bar_layer_set_click_config_provider(ActionBarLayer *action_bar, ClickConfigProvider provider);
+
+// Animations
+
+typedef struct Animation Animation;
+typedef uint32_t AnimationProgress;
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef void (*AnimationSetupImplementation)(Animation *animation);
+typedef void (*AnimationUpdateImplementation)(Animation *animation, const AnimationProgress progress);
+typedef void (*AnimationTeardownImplementation)(Animation *animation);
+typedef struct AnimationImplementation {
+  AnimationSetupImplementation setup;
+  AnimationUpdateImplementation update;
+  AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+typedef void (*AnimationStartedHandler)(Animation *animation, void *context);
+typedef void (*AnimationStoppedHandler)(Animation *animation, bool finished, void *context);
+typedef struct AnimationHandlers {
+  AnimationStartedHandler started;
+  AnimationStoppedHandler stopped;
+} AnimationHandlers;
+
+Animation *animation_create(void);
+bool animation_destroy(Animation *animation);
+bool animation_set_duration(Animation *animation, uint32_t duration_ms);
+bool animation_set_elapsed(Animation *animation, uint32_t elapsed_ms);
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation);
+bool animation_set_handlers(Animation *animation, AnimationHandlers handlers, void *context);
+bool animation_schedule(Animation *animation);
+bool animation_unschedule(Animation *animation);
+
+// a property animation is an Animation here, the app only casts between the two
+typedef struct Animation PropertyAnimation;
+PropertyAnimation *property_animation_create_layer_frame(Layer *layer, GRect *from_frame, GRect *to_frame);
+void property_animation_destroy(PropertyAnimation *property_animation);
+
+// Services
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *data);
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer);
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT = 1 << 2,
+  DAY_UNIT = 1 << 3
+} TimeUnits;
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+void tick_timer_service_subscribe(TimeUnits units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef void (*AppFocusHandler)(bool in_focus);
+typedef struct AppFocusHandlers {
+  AppFocusHandler will_focus;
+  AppFocusHandler did_focus;
+} AppFocusHandlers;
+void app_focus_service_subscribe_handlers(AppFocusHandlers handlers);
+void app_focus_service_unsubscribe(void);
+
+typedef void (*ConnectionHandler)(bool connected);
+typedef struct ConnectionHandlers {
+  ConnectionHandler pebble_app_connection_handler;
+  ConnectionHandler pebblekit_connection_handler;
+} ConnectionHandlers;
+void connection_service_subscribe(ConnectionHandlers handlers);
+void connection_service_unsubscribe(void);
+bool connection_service_peek_pebble_app_connection(void);
+
+void vibes_short_pulse(void);
+void vibes_double_pulse(void);
+void vibes_long_pulse(void);
+void light_enable_interaction(void);
+
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+typedef enum {
+  APP_LAUNCH_SYSTEM,
+  APP_LAUNCH_USER,
+  APP_LAUNCH_PHONE,
+  APP_LAUNCH_WAKEUP,
+  APP_LAUNCH_WORKER,
+  APP_LAUNCH_QUICK_LAUNCH,
+  APP_LAUNCH_TIMELINE_ACTION
+} AppLaunchReason;
+AppLaunchReason launch_reason(void);
+
+void app_event_loop(void);
+
+// Persistent storage
+
+typedef int32_t status_t;
+#define S_SUCCESS 0
+#define E_ERROR (-1)
+#define E_DOES_NOT_EXIST (-4)
+#define E_OUT_OF_RESOURCES (-7)
+#define E_RANGE (-8)
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(uint32_t key);
+int persist_get_size(uint32_t key);
+int32_t persist_read_int(uint32_t key);
+bool persist_read_bool(uint32_t key);
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size);
+status_t persist_write_int(uint32_t key, int32_t value);
+status_t persist_write_bool(uint32_t key, bool value);
+int persist_write_data(uint32_t key, const void *data, size_t size);
+status_t persist_delete(uint32_t key);
+
+// Wakeup
+
+typedef int32_t WakeupId;
+WakeupId wakeup_schedule(time_t timestamp, int32_t cookie, bool notify_if_missed);
+void wakeup_cancel(WakeupId wakeup_id);
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp);
+
+// AppMessage
+
+typedef struct DictionaryIterator DictionaryIterator;
+
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3
+} TupleType;
+
+typedef struct Tuple {
+  uint32_t key;
+  TupleType type;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef enum {
+  DICT_OK = 0,
+  DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+  DICT_INVALID_ARGS = 1 << 2
+} DictionaryResult;
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, uint32_t key, uint8_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, uint32_t key, int32_t value);
+DictionaryResult dict_write_data(DictionaryIterator *iter, uint32_t key, const uint8_t *data, uint16_t size);
+Tuple *dict_find(const DictionaryIterator *iter, uint32_t key);
+uint32_t dict_calc_buffer_size(uint8_t tuple_count, ...);
+
+typedef enum {
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 1 << 1,
+  APP_MSG_NOT_CONNECTED = 1 << 3,
+  APP_MSG_BUSY = 1 << 6
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+AppMessageResult app_message_open(uint32_t size_inbound, uint32_t size_outbound);
+void app_message_register_inbox_received(AppMessageInboxReceived callback);
+void app_message_register_outbox_failed(AppMessageOutboxFailed callback);
+void app_message_deregister_callbacks(void);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+#endif /* PEBBLE_H */
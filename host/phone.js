@@ -0,0 +1,81 @@
+// The phone for the host build: runs src/history_sync.js as PebbleKit JS
+// would, against an in-memory localStorage. fake_pebble.c writes one event
+// per line on stdin:
+//   {"event": "ready"}                     the watchapp was opened
+//   {"event": "appmessage", "payload": {}}  a message from the watch, by key number
+//   {"event": "clear"}                     the phone app lost its storage
+//   {"event": "history"}                   lists the stored days
+// and reads back the messages sent to the watch, one per line as
+// key=value pairs, or the stored days, followed by a line "end".
+
+var readline = require('readline');
+
+var appKeys = require('../appinfo.json').appKeys;
+var keyNames = {};
+Object.keys(appKeys).forEach(function(name) {
+  keyNames[appKeys[name]] = name;
+});
+
+var storage = {};
+var listeners = {};
+var outbox = [];
+
+global.localStorage = {
+  getItem: function(key) {
+    return storage.hasOwnProperty(key) ? storage[key] : null;
+  },
+  setItem: function(key, value) {
+    storage[key] = String(value);
+  }
+};
+
+global.Pebble = {
+  addEventListener: function(type, listener) {
+    listeners[type] = listener;
+  },
+  sendAppMessage: function(message, success, failure) {
+    outbox.push(message);
+  }
+};
+
+require('../src/history_sync.js');
+
+function formatMessage(message) {
+  return Object.keys(message).map(function(name) {
+    if (!(name in appKeys) || message[name] !== (message[name] | 0)) {
+      throw new Error('Cannot send ' + name + ' to the watch');
+    }
+    return appKeys[name] + '=' + message[name];
+  }).join(' ');
+}
+
+function handleEvent(event) {
+  switch (event.event) {
+    case 'ready':
+      listeners.ready({});
+      break;
+    case 'appmessage':
+      var payload = {};
+      Object.keys(event.payload).forEach(function(key) {
+        payload[keyNames[key]] = event.payload[key];
+      });
+      listeners.appmessage({ payload: payload });
+      break;
+    case 'clear':
+      storage = {};
+      break;
+    case 'history':
+      var history = JSON.parse(localStorage.getItem('history') || '{}');
+      return Object.keys(history).sort().map(function(date) {
+        var day = history[date];
+        return [date, day.completed, day.skipped, day.longBreaks].join(' ');
+      });
+  }
+  var lines = outbox.map(formatMessage);
+  outbox = [];
+  return lines;
+}
+
+readline.createInterface({ input: process.stdin, terminal: false }).on('line', function(line) {
+  process.stdout.write(handleEvent(JSON.parse(line)).concat('end').join('\n') + '\n');
+});
@@ -0,0 +1,54 @@
+// Renders every minute of the scale, an adjust animation, the switch to the
+// break, the break countdown, the count and the menu into frames.raw, which
+// wscript `sweep` turns into PNGs and compares with host/golden/.
+#include "host.h"
+
+#define SWEEP_START 1772442000 // Monday 2026-03-02 09:00 UTC
+#define MAX_ACTIONS 256
+
+static HostAction actions[MAX_ACTIONS];
+static size_t action_count;
+static time_t at = SWEEP_START;
+
+static void add(int seconds, HostActionType type, ButtonId button, const char *name, int frames) {
+  at += seconds;
+  actions[action_count++] = (HostAction) { at, type, button, name, frames };
+}
+
+static char minute_names[60][16];
+
+int main(void) {
+  add(0, HOST_LAUNCH, 0, NULL, 0);
+  // paused, so the scale only moves on clicks and the clock reads "Paused"
+  add(1, HOST_LONG_CLICK, BUTTON_ID_DOWN, NULL, 0);
+  // a fresh pomodoro is 25 minutes, each click takes one off
+  for (int i = 0; i < 25; i++) {
+    add(1, HOST_CLICK, BUTTON_ID_UP, NULL, 0);
+  }
+  for (int minute = 0; minute < 60; minute++) {
+    if (minute > 0) {
+      add(1, HOST_CLICK, BUTTON_ID_DOWN, NULL, 0);
+    }
+    snprintf(minute_names[minute], sizeof(minute_names[minute]), "minute-%02d", minute);
+    add(1, HOST_CAPTURE, 0, minute_names[minute], 1);
+  }
+  // every frame of the slide after a click
+  add(1, HOST_CLICK, BUTTON_ID_UP, NULL, 0);
+  add(0, HOST_CAPTURE, 0, "adjust", 10);
+  // resumed and skipped to the break
+  add(2, HOST_LONG_CLICK, BUTTON_ID_DOWN, NULL, 0);
+  add(1, HOST_LONG_CLICK, BUTTON_ID_UP, NULL, 0);
+  add(0, HOST_CAPTURE, 0, "switch", 9);
+  add(2, HOST_CAPTURE, 0, "break", 1);
+  add(2, HOST_CLICK, BUTTON_ID_SELECT, NULL, 0);
+  add(1, HOST_CAPTURE, 0, "count", 1);
+  add(1, HOST_CLICK, BUTTON_ID_BACK, NULL, 0);
+  add(1, HOST_LONG_CLICK, BUTTON_ID_SELECT, NULL, 0);
+  add(1, HOST_CAPTURE, 0, "menu", 1);
+  add(1, HOST_CLICK, BUTTON_ID_BACK, NULL, 0);
+
+  remove("frames.raw");
+  host_init(SWEEP_START);
+  host_run(actions, action_count, at + 5);
+  return 0;
+}
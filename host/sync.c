@@ -0,0 +1,109 @@
+// Exports the watch history to the phone stand-in given on the command line,
+// see host/phone.js. The phone loses its copy overnight and asks for
+// everything again just as the watch sends the day before, in the end it
+// has to hold the same days as the watch.
+#include "host.h"
+#include "../src/history.h"
+
+#define DAY_START 1772409600 // Monday 2026-03-02 00:00 UTC
+#define AT(day, hour, minute) (DAY_START + (day) * SECONDS_PER_DAY + (hour) * SECONDS_PER_HOUR + (minute) * SECONDS_PER_MINUTE)
+#define PAST_DAYS 10
+#define MAX_PHONE_DAYS (HISTORY_DAYS + 1)
+
+static const HostAction sync_day[] = {
+  { .at = AT(0, 8, 0), .type = HOST_PHONE_CONNECT },
+  { .at = AT(0, 9, 0), .type = HOST_LAUNCH },
+  // paused, so no wakeup opens the app overnight
+  { .at = AT(0, 9, 0) + 5, .type = HOST_LONG_CLICK, .button = BUTTON_ID_DOWN },
+  { .at = AT(0, 9, 0) + 10, .type = HOST_CLICK, .button = BUTTON_ID_BACK },
+  { .at = AT(0, 20, 0), .type = HOST_PHONE_CLEAR },
+  { .at = AT(1, 9, 0), .type = HOST_LAUNCH },
+  { .at = AT(1, 9, 0) + 10, .type = HOST_CLICK, .button = BUTTON_ID_BACK },
+};
+
+typedef struct PhoneDay {
+  char date[11];
+  HistoryDay counts;
+} PhoneDay;
+
+static PhoneDay phone_days[MAX_PHONE_DAYS];
+static size_t phone_day_count;
+
+static void read_phone_day(const char *line, void *context) {
+  unsigned completed, skipped, long_breaks;
+  PhoneDay *day = &phone_days[phone_day_count];
+  if (phone_day_count < MAX_PHONE_DAYS &&
+      sscanf(line, "%10s %u %u %u", day->date, &completed, &skipped, &long_breaks) == 4) {
+    day->counts = (HistoryDay) { .completed = completed, .skipped = skipped, .long_breaks = long_breaks };
+    phone_day_count++;
+  }
+}
+
+// The phone keys its days by date
+static void format_date(char date[11], uint16_t day) {
+  time_t timestamp = day * SECONDS_PER_DAY;
+  strftime(date, 11, "%Y-%m-%d", gmtime(&timestamp));
+}
+
+static HistoryDay phone_get(const char *date) {
+  for (size_t i = 0; i < phone_day_count; i++) {
+    if (strcmp(phone_days[i].date, date) == 0) {
+      return phone_days[i].counts;
+    }
+  }
+  return (HistoryDay) {};
+}
+
+static bool is_same_day(HistoryDay a, HistoryDay b) {
+  return a.completed == b.completed && a.skipped == b.skipped && a.long_breaks == b.long_breaks;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s phone-command...\n", argv[0]);
+    return 2;
+  }
+  // starts with the days before the run, Monday included, some of them empty
+  host_init(AT(-PAST_DAYS, 0, 0));
+  host_phone_open(argv + 1);
+  load_history();
+  for (int i = PAST_DAYS; i >= 0; i--) {
+    if (i % 4 == 3) {
+      continue;
+    }
+    time_t at = AT(-i, 12, 0);
+    for (int count = i * 5 % 9 + 1; count > 0; count--) {
+      history_add_completed(at);
+    }
+    for (int count = i % 3; count > 0; count--) {
+      history_add_skipped(at);
+    }
+    for (int count = i % 4 / 2; count > 0; count--) {
+      history_add_long_break(at);
+    }
+  }
+  save_history();
+
+  uint16_t monday = history_day(AT(0, 0, 0));
+  host_run(sync_day, ARRAY_LENGTH(sync_day), AT(1, 12, 0));
+
+  load_history();
+  host_phone_event("{\"event\": \"history\"}", read_phone_day, NULL);
+  int synced = 0;
+  int differing = 0;
+  for (uint16_t day = monday - HISTORY_DAYS + 1; day <= monday; day++) {
+    HistoryDay watch = history_get(day);
+    char date[11];
+    format_date(date, day);
+    HistoryDay phone = phone_get(date);
+    if (!is_same_day(watch, phone)) {
+      printf("%s: watch %u/%u/%u, phone %u/%u/%u\n", date, watch.completed, watch.skipped, watch.long_breaks,
+             phone.completed, phone.skipped, phone.long_breaks);
+      differing++;
+    } else if (watch.completed || watch.skipped || watch.long_breaks) {
+      synced++;
+    }
+  }
+  printf("%d days synced, %d differ\n", synced, differing);
+  return differing ? 1 : 0;
+}
@@ -0,0 +1,48 @@
+// A workday against the simulated watch: the app is opened once in the
+// morning and then left to cycle through pomodoros and breaks on its own
+// wakeups, with some adjusting, a notification and a paused lunch.
+#include "host.h"
+
+#define DAY_START 1772409600 // Monday 2026-03-02 00:00 UTC
+#define AT(hour, minute) (DAY_START + (hour) * SECONDS_PER_HOUR + (minute) * SECONDS_PER_MINUTE)
+#define FIRST_HOUR 8
+#define LAST_HOUR 18
+
+static const HostAction workday[] = {
+  { .at = AT(9, 0), .type = HOST_LAUNCH },
+  // a longer first pomodoro
+  { .at = AT(9, 0) + 2, .type = HOST_CLICK, .button = BUTTON_ID_DOWN },
+  { .at = AT(9, 0) + 3, .type = HOST_CLICK, .button = BUTTON_ID_DOWN },
+  { .at = AT(10, 5), .type = HOST_FOCUS_LOST },
+  { .at = AT(10, 6), .type = HOST_FOCUS_GAINED },
+  { .at = AT(11, 20), .type = HOST_LAUNCH },
+  { .at = AT(11, 20) + 2, .type = HOST_CLICK, .button = BUTTON_ID_UP },
+  { .at = AT(12, 30), .type = HOST_LONG_CLICK, .button = BUTTON_ID_DOWN },
+  { .at = AT(13, 30), .type = HOST_LONG_CLICK, .button = BUTTON_ID_DOWN },
+  // a look at the day's count
+  { .at = AT(15, 10), .type = HOST_CLICK, .button = BUTTON_ID_SELECT },
+  { .at = AT(15, 10) + 5, .type = HOST_CLICK, .button = BUTTON_ID_BACK },
+  // skip a break
+  { .at = AT(16, 0), .type = HOST_LONG_CLICK, .button = BUTTON_ID_UP },
+  { .at = AT(17, 30), .type = HOST_LONG_CLICK, .button = BUTTON_ID_DOWN },
+};
+
+static void print_stats(const char *label, const HostStats *stats) {
+  printf("%-6s %8lu %8lu %8lu %8lu %8lu %6lu\n", label, (unsigned long) stats->launches,
+         (unsigned long) stats->wakeups, (unsigned long) stats->redraws, (unsigned long) stats->persist_writes,
+         (unsigned long) stats->persist_bytes, (unsigned long) stats->vibes);
+}
+
+int main(void) {
+  host_init(AT(FIRST_HOUR, 0));
+  host_run(workday, ARRAY_LENGTH(workday), AT(LAST_HOUR, 0));
+
+  printf("%-6s %8s %8s %8s %8s %8s %6s\n", "hour", "launches", "wakeups", "redraws", "writes", "bytes", "vibes");
+  for (int hour = FIRST_HOUR; hour < LAST_HOUR; hour++) {
+    char label[8];
+    snprintf(label, sizeof(label), "%02d:00", hour);
+    print_stats(label, host_hour_stats(hour));
+  }
+  print_stats("total", host_stats());
+  return 0;
+}
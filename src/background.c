@@ -0,0 +1,168 @@
+#include "background.h"
+
+#ifdef PBL_COLOR
+
+// Everything needed to walk a bitmap's rows, fetched once per bitmap
+typedef struct PixelSource {
+  const uint8_t *data;
+  uint16_t row_size;
+  GBitmapFormat format;
+  const GColor *palette;
+  GRect bounds;
+  // where the bitmap's top left lands, centered as a BitmapLayer shows it
+  GPoint offset;
+} PixelSource;
+
+static PixelSource pixel_source(GSize size, const GBitmap *bitmap) {
+  GRect bounds = gbitmap_get_bounds(bitmap);
+  return (PixelSource) {
+    .data = gbitmap_get_data(bitmap),
+    .row_size = gbitmap_get_bytes_per_row(bitmap),
+    .format = gbitmap_get_format(bitmap),
+    .palette = gbitmap_get_palette(bitmap),
+    .bounds = bounds,
+    .offset = GPoint((size.w - bounds.size.w) / 2, (size.h - bounds.size.h) / 2)
+  };
+}
+
+// Row y of the frame as the source covers it, clear where it does not. Any
+// format resource bitmaps load as, palettized rows are packed most
+// significant bits first.
+static void read_row(const PixelSource *source, int y, GColor *line, int width) {
+  memset(line, GColorClearARGB8, width * sizeof(GColor));
+  int source_y = y - source->offset.y;
+  if (source_y < 0 || source_y >= source->bounds.size.h) {
+    return;
+  }
+  const uint8_t *row = source->data + (source->bounds.origin.y + source_y) * source->row_size;
+  int from = MAX(source->offset.x, 0);
+  int to = MIN(source->offset.x + source->bounds.size.w, width);
+  int bits;
+  switch (source->format) {
+    case GBitmapFormat8Bit:
+      for (int x = from; x < to; x++) {
+        line[x].argb = row[source->bounds.origin.x + x - source->offset.x];
+      }
+      return;
+    case GBitmapFormat1Bit:
+      for (int x = from; x < to; x++) {
+        int source_x = source->bounds.origin.x + x - source->offset.x;
+        line[x] = row[source_x / 8] & (1 << source_x % 8) ? GColorWhite : GColorBlack;
+      }
+      return;
+    case GBitmapFormat1BitPalette:
+      bits = 1;
+      break;
+    case GBitmapFormat2BitPalette:
+      bits = 2;
+      break;
+    case GBitmapFormat4BitPalette:
+      bits = 4;
+      break;
+    default:
+      return;
+  }
+  int per_byte = 8 / bits;
+  uint8_t index_mask = (1 << bits) - 1;
+  for (int x = from; x < to; x++) {
+    int source_x = source->bounds.origin.x + x - source->offset.x;
+    int shift = (per_byte - 1 - source_x % per_byte) * bits;
+    line[x] = source->palette[(row[source_x / per_byte] >> shift) & index_mask];
+  }
+}
+
+// Same result as drawing src over dst with GCompOpSet
+static GColor blend(GColor dst, GColor src) {
+  if (src.a == 3) {
+    return src;
+  } else if (src.a == 0) {
+    return dst;
+  }
+  dst.r = (src.r * src.a + dst.r * (3 - src.a)) / 3;
+  dst.g = (src.g * src.a + dst.g * (3 - src.a)) / 3;
+  dst.b = (src.b * src.a + dst.b * (3 - src.a)) / 3;
+  return dst;
+}
+
+// Composites the color, the artwork and the mask (both centered, as a
+// BitmapLayer shows them) into one opaque 8-bit frame, and records for
+// every row of band which columns the mask leaves uncovered. The mask must
+// leave one contiguous gap per band row, otherwise there is no composite
+// and the caller keeps the layers.
+GBitmap *background_create(GSize size, GColor color, const GBitmap *artwork, const GBitmap *mask,
+                           GRect band, BandClip *clips) {
+  GBitmap *background = gbitmap_create_blank(size, GBitmapFormat8Bit);
+  if (!background) {
+    return NULL;
+  }
+  
+  PixelSource artwork_source = pixel_source(size, artwork);
+  PixelSource mask_source = pixel_source(size, mask);
+  GColor artwork_line[size.w];
+  GColor mask_line[size.w];
+  uint8_t *row = gbitmap_get_data(background);
+  uint16_t row_size = gbitmap_get_bytes_per_row(background);
+  for (int y = 0; y < size.h; y++, row += row_size) {
+    read_row(&artwork_source, y, artwork_line, size.w);
+    read_row(&mask_source, y, mask_line, size.w);
+    for (int x = 0; x < size.w; x++) {
+      row[x] = blend(blend(color, artwork_line[x]), mask_line[x]).argb;
+    }
+    
+    int band_y = y - band.origin.y;
+    if (band_y < 0 || band_y >= band.size.h) {
+      continue;
+    }
+    int from = band.size.w;
+    int to = 0;
+    for (int x = 0; x < band.size.w; x++) {
+      int frame_x = band.origin.x + x;
+      if (frame_x < 0 || frame_x >= size.w || mask_line[frame_x].a == 0) {
+        if (to > 0 && to < x) {
+          // covered columns inside the gap, one span per row cannot restore them
+          APP_LOG(APP_LOG_LEVEL_WARNING, "Mask gap split in band row %d", band_y);
+          gbitmap_destroy(background);
+          return NULL;
+        }
+        from = MIN(from, x);
+        to = x + 1;
+      }
+    }
+    clips[band_y] = (BandClip) { .from = from, .to = MAX(from, to) };
+  }
+  return background;
+}
+
+static void copy_span(GBitmapDataRowInfo row, int screen_x, const uint8_t *src, int from, int to) {
+  from = MAX(from, row.min_x - screen_x);
+  to = MIN(to, row.max_x + 1 - screen_x);
+  if (from < to) {
+    memcpy(row.data + screen_x + from, src + from, to - from);
+  }
+}
+
+// Puts the background back over whatever was drawn into the band where
+// the mask covers it, which is what the mask layer on top used to do
+void background_restore_band(GContext *ctx, const GBitmap *background, GPoint screen_origin,
+                             GRect band, const BandClip *clips) {
+  GBitmap *frame = graphics_capture_frame_buffer(ctx);
+  if (!frame) {
+    return;
+  }
+  int frame_height = gbitmap_get_bounds(frame).size.h;
+  const uint8_t *data = gbitmap_get_data(background);
+  uint16_t row_size = gbitmap_get_bytes_per_row(background);
+  for (int y = 0; y < band.size.h; y++) {
+    int screen_y = screen_origin.y + y;
+    if (screen_y < 0 || screen_y >= frame_height) {
+      continue;
+    }
+    GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame, screen_y);
+    const uint8_t *src = data + (band.origin.y + y) * row_size + band.origin.x;
+    copy_span(row, screen_origin.x, src, 0, clips[y].from);
+    copy_span(row, screen_origin.x, src, clips[y].to, band.size.w);
+  }
+  graphics_release_frame_buffer(ctx, frame);
+}
+
+#endif /* PBL_COLOR */
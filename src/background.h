@@ -0,0 +1,23 @@
+#include <pebble.h>
+
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#ifdef PBL_COLOR
+
+// Columns [from, to) of a band row are outside the mask, which has to leave
+// a single gap in every row of the band
+typedef struct BandClip {
+  uint8_t from;
+  uint8_t to;
+} BandClip;
+
+GBitmap *background_create(GSize size, GColor color, const GBitmap *artwork, const GBitmap *mask,
+                           GRect band, BandClip *clips);
+
+void background_restore_band(GContext *ctx, const GBitmap *background, GPoint screen_origin,
+                             GRect band, const BandClip *clips);
+
+#endif /* PBL_COLOR */
+
+#endif /* BACKGROUND_H */
@@ -0,0 +1,107 @@
+#include "checkpoint.h"
+#include "settings.h"
+#include "history.h"
+#include "profile.h"
+
+// The running or paused period and today's counts. Records alternate between
+// CHECKPOINT_KEY and CHECKPOINT_KEY + 1, so a write torn by a reset or a
+// dead battery leaves the previous one intact; the higher valid seq wins.
+typedef struct Checkpoint {
+  uint8_t version;
+  uint32_t seq;
+  int32_t end_time;
+  int32_t paused_remaining;
+  uint8_t state;
+  uint16_t day;
+  HistoryDay today;
+  uint16_t crc;
+} __attribute__((__packed__)) Checkpoint;
+
+static Checkpoint last_checkpoint;
+static AppTimer *settle_timer;
+static int settle_paused_remaining;
+
+// CRC-16/CCITT of everything before the crc field
+static uint16_t checkpoint_crc(const Checkpoint *checkpoint) {
+  const uint8_t *data = (const uint8_t *) checkpoint;
+  uint16_t crc = 0xffff;
+  for (size_t i = 0; i < offsetof(Checkpoint, crc); i++) {
+    crc ^= data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static bool read_checkpoint(uint32_t key, Checkpoint *checkpoint) {
+  return persist_read_data(key, checkpoint, sizeof(*checkpoint)) == sizeof(*checkpoint) &&
+    checkpoint->version == CHECKPOINT_VERSION &&
+    checkpoint->crc == checkpoint_crc(checkpoint);
+}
+
+void checkpoint_save(int paused_remaining) {
+  if (settle_timer) {
+    app_timer_cancel(settle_timer);
+    settle_timer = NULL;
+  }
+  
+  TomatoSettings *settings = get_settings();
+  uint16_t day = history_day(time(NULL));
+  Checkpoint checkpoint = {
+    .version = CHECKPOINT_VERSION,
+    .seq = last_checkpoint.seq,
+    .end_time = settings->end_time,
+    .paused_remaining = paused_remaining,
+    .state = settings->state,
+    .day = day,
+    .today = history_get(day)
+  };
+  checkpoint.crc = checkpoint_crc(&checkpoint);
+  if (memcmp(&checkpoint, &last_checkpoint, sizeof(checkpoint)) == 0) {
+    return;
+  }
+  
+  checkpoint.seq++;
+  checkpoint.crc = checkpoint_crc(&checkpoint);
+  PROFILE_BEGIN(PROFILE_PERSIST);
+  persist_write_data(CHECKPOINT_KEY + (checkpoint.seq & 1), &checkpoint, sizeof(checkpoint));
+  PROFILE_END(PROFILE_PERSIST);
+  PROFILE_COUNT(PROFILE_PERSIST_WRITES, 1);
+  PROFILE_COUNT(PROFILE_PERSIST_BYTES, sizeof(checkpoint));
+  last_checkpoint = checkpoint;
+}
+
+static void settle_callback(void *data) {
+  settle_timer = NULL;
+  checkpoint_save(settle_paused_remaining);
+}
+
+void checkpoint_save_later(int paused_remaining) {
+  settle_paused_remaining = paused_remaining;
+  if (!settle_timer || !app_timer_reschedule(settle_timer, CHECKPOINT_SETTLE_MS)) {
+    settle_timer = app_timer_register(CHECKPOINT_SETTLE_MS, settle_callback, NULL);
+  }
+}
+
+// Puts the latest valid record back into settings and history, returns whether there was one
+bool checkpoint_restore(int *paused_remaining) {
+  Checkpoint records[2];
+  bool is_valid[2];
+  for (int i = 0; i < 2; i++) {
+    is_valid[i] = read_checkpoint(CHECKPOINT_KEY + i, &records[i]);
+  }
+  if (!is_valid[0] && !is_valid[1]) {
+    return false;
+  }
+  
+  Checkpoint *latest = !is_valid[1] || (is_valid[0] && records[0].seq > records[1].seq) ?
+    &records[0] : &records[1];
+  TomatoSettings *settings = get_settings();
+  settings->end_time = latest->end_time;
+  settings->state = latest->state;
+  *paused_remaining = latest->paused_remaining;
+  history_merge_day(latest->day, latest->today);
+  last_checkpoint = *latest;
+  return true;
+}
@@ -0,0 +1,18 @@
+#include <pebble.h>
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#define CHECKPOINT_VERSION 2
+
+// Adjust clicks come in bursts, they are checkpointed once the burst settles
+#define CHECKPOINT_SETTLE_MS 1500
+
+// paused_remaining is the frozen remainder of a paused period, -1 while running
+void checkpoint_save(int paused_remaining);
+
+void checkpoint_save_later(int paused_remaining);
+
+bool checkpoint_restore(int *paused_remaining);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,83 @@
+#include <pebble.h>
+#include "deadline_queue.h"
+
+// Binary min-heap of deadlines, each id appears at most once
+static time_t deadlines[DEADLINE_QUEUE_SIZE];
+static uint8_t ids[DEADLINE_QUEUE_SIZE];
+static int count;
+
+// Heap position of every id plus one, zero when the id is not queued
+static uint8_t positions[DEADLINE_QUEUE_SIZE];
+
+static void place(int i, uint8_t id, time_t deadline) {
+  ids[i] = id;
+  deadlines[i] = deadline;
+  positions[id] = i + 1;
+}
+
+static int sift_up(int i) {
+  uint8_t id = ids[i];
+  time_t deadline = deadlines[i];
+  while (i > 0 && deadlines[(i - 1) / 2] > deadline) {
+    int parent = (i - 1) / 2;
+    place(i, ids[parent], deadlines[parent]);
+    i = parent;
+  }
+  place(i, id, deadline);
+  return i;
+}
+
+static void sift_down(int i) {
+  uint8_t id = ids[i];
+  time_t deadline = deadlines[i];
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= count) {
+      break;
+    }
+    if (child + 1 < count && deadlines[child + 1] < deadlines[child]) {
+      child++;
+    }
+    if (deadlines[child] >= deadline) {
+      break;
+    }
+    place(i, ids[child], deadlines[child]);
+    i = child;
+  }
+  place(i, id, deadline);
+}
+
+// Queues the id or moves its deadline
+void deadline_queue_set(uint8_t id, time_t deadline) {
+  int i = positions[id] - 1;
+  if (i < 0) {
+    i = count++;
+  }
+  deadlines[i] = deadline;
+  ids[i] = id;
+  sift_down(sift_up(i));
+}
+
+void deadline_queue_remove(uint8_t id) {
+  int i = positions[id] - 1;
+  if (i < 0) {
+    return;
+  }
+  positions[id] = 0;
+  if (i == --count) {
+    return;
+  }
+  deadlines[i] = deadlines[count];
+  ids[i] = ids[count];
+  sift_down(sift_up(i));
+}
+
+// The earliest deadline, false when nothing is queued
+bool deadline_queue_peek(uint8_t *id, time_t *deadline) {
+  if (count == 0) {
+    return false;
+  }
+  *id = ids[0];
+  *deadline = deadlines[0];
+  return true;
+}
@@ -0,0 +1,14 @@
+#include <pebble.h>
+
+#ifndef DEADLINE_QUEUE_H
+#define DEADLINE_QUEUE_H
+
+#define DEADLINE_QUEUE_SIZE 8
+
+void deadline_queue_set(uint8_t id, time_t deadline);
+
+void deadline_queue_remove(uint8_t id);
+
+bool deadline_queue_peek(uint8_t *id, time_t *deadline);
+
+#endif /* DEADLINE_QUEUE_H */
@@ -1,7 +1,10 @@
 #include <pebble.h>
 #include "edit_number.h"
+#include "resource_cache.h"
+#include "profile.h"
 
-// BEGIN AUTO-GENERATED UI CODE; DO NOT MODIFY
+// Started out as generated UI code, edited by hand since its bitmaps and
+// fonts come from the resource cache, so it is no longer regenerated
 static Window *s_window;
 static GBitmap *s_res_image_action_increment;
 static GBitmap *s_res_image_action_decrement;
@@ -24,9 +27,6 @@ static void initialise_ui(void) {
     window_set_fullscreen(s_window, 0);
   #endif
   
-  s_res_image_action_increment = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_ACTION_INCREMENT);
-  s_res_image_action_decrement = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_ACTION_DECREMENT);
-  s_res_font_dd_50 = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_DD_50));
   s_res_gothic_18 = fonts_get_system_font(FONT_KEY_GOTHIC_18);
   // action_bar_layer
   action_bar_layer = action_bar_layer_create();
@@ -61,20 +61,40 @@ static void destroy_ui(void) {
   action_bar_layer_destroy(action_bar_layer);
   text_layer_destroy(number_text_layer);
   text_layer_destroy(title_text_layer);
-  gbitmap_destroy(s_res_image_action_increment);
-  gbitmap_destroy(s_res_image_action_decrement);
-  fonts_unload_custom_font(s_res_font_dd_50);
 }
-// END AUTO-GENERATED UI CODE
+
+// Resources come from the shared cache, held for as long as the window exists
+static void acquire_resources(void) {
+  s_res_image_action_increment = acquire_bitmap(RESOURCE_ID_IMAGE_ACTION_INCREMENT);
+  s_res_image_action_decrement = acquire_bitmap(RESOURCE_ID_IMAGE_ACTION_DECREMENT);
+  s_res_font_dd_50 = acquire_font(RESOURCE_ID_FONT_DD_50);
+}
+
+static void release_resources(void) {
+  release_bitmap(RESOURCE_ID_IMAGE_ACTION_INCREMENT);
+  release_bitmap(RESOURCE_ID_IMAGE_ACTION_DECREMENT);
+  release_font(RESOURCE_ID_FONT_DD_50);
+}
 
 static int s_value = 0;
 static int s_min_value = 0;
 static int s_max_value = 0;
 static int s_default_value = 0;
-static int s_setting_key = 0;
+static int s_setting = 0;
+static int s_saved_value = 0;
 
-static void handle_window_unload(Window* window) {
-  destroy_ui();
+static void handle_window_appear(Window* window) {
+  PROFILE_END(PROFILE_WINDOW);
+}
+
+// Repeating clicks only change s_value, it is written once when the editor closes
+static void handle_window_disappear(Window* window) {
+  if (s_value == s_saved_value) {
+    return;
+  }
+  set_setting_value(s_setting, s_value);
+  save_settings();
+  s_saved_value = s_value;
 }
 
 static void update_number() {
@@ -89,7 +109,6 @@ static void increment_click_handler(ClickRecognizerRef recognizer, void *context
   }
   s_value++;
   update_number();
-  persist_write_int(s_setting_key, s_value);
 }
 
 static void decrement_click_handler(ClickRecognizerRef recognizer, void *context) {
@@ -98,7 +117,6 @@ static void decrement_click_handler(ClickRecognizerRef recognizer, void *context
   }
   s_value--;
   update_number();
-  persist_write_int(s_setting_key, s_value);
 }
 
 static void reset_click_handler(ClickRecognizerRef recognizer, void *context) {
@@ -107,7 +125,6 @@ static void reset_click_handler(ClickRecognizerRef recognizer, void *context) {
   }
   s_value = s_default_value;
   update_number();
-  persist_write_int(s_setting_key, s_value);
 }
 
 static void click_config_provider(void *context) {
@@ -122,9 +139,10 @@ static void init_action_bar() {
   action_bar_layer_set_click_config_provider(action_bar_layer, click_config_provider);
 }
 
-static void set_values(int setting_key, int value, SettingParams params) {
-  s_setting_key = setting_key;
+static void set_values(int setting, int value, SettingParams params) {
+  s_setting = setting;
   s_value = value;
+  s_saved_value = value;
   s_default_value = params.default_value;
   s_max_value = params.max_value;
   s_min_value = params.min_value;
@@ -133,18 +151,31 @@ static void set_values(int setting_key, int value, SettingParams params) {
   text_layer_set_text(title_text_layer, params.title);
 }
 
-void show_edit_number(int setting_key, int value, SettingParams params) {
-  initialise_ui();
-  init_action_bar();
-  
-  set_values(setting_key, value, params);
+// The window is built on first use and kept, each show only sets its values
+void show_edit_number(int setting, int value, SettingParams params) {
+  PROFILE_BEGIN(PROFILE_WINDOW);
+  if (!s_window) {
+    acquire_resources();
+    initialise_ui();
+    init_action_bar();
+    window_set_window_handlers(s_window, (WindowHandlers) {
+      .appear = handle_window_appear,
+      .disappear = handle_window_disappear
+    });
+  }
   
-  window_set_window_handlers(s_window, (WindowHandlers) {
-    .unload = handle_window_unload,
-  });
+  set_values(setting, value, params);
   window_stack_push(s_window, true);
 }
 
 void hide_edit_number(void) {
   window_stack_remove(s_window, true);
 }
+
+void edit_number_deinit(void) {
+  if (s_window) {
+    destroy_ui();
+    release_resources();
+    s_window = NULL;
+  }
+}
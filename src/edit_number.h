@@ -1,4 +1,5 @@
 #include "settings.h"
 
-void show_edit_number(int setting_key, int value, SettingParams params);
+void show_edit_number(int setting, int value, SettingParams params);
 void hide_edit_number(void);
+void edit_number_deinit(void);
@@ -0,0 +1,167 @@
+#include <pebble.h>
+#include "glyph_atlas.h"
+
+#define GLYPH_CHARS "0123456789:"
+#define GLYPH_COUNT (sizeof(GLYPH_CHARS) - 1)
+#define GLYPH_COLUMNS 6
+#define GLYPH_CELL_WIDTH (GLYPH_ATLAS_WIDTH / GLYPH_COLUMNS)
+#define GLYPH_CELL_HEIGHT (GLYPH_ATLAS_HEIGHT / 2)
+
+static GFont atlas_font;
+static bool is_rendered;
+static GBitmap *atlas;
+static GBitmap *glyphs[GLYPH_COUNT];
+static uint8_t glyph_widths[GLYPH_COUNT];
+
+#ifdef PBL_COLOR
+// Antialiased glyphs are kept as 2-bit coverage, recolored through the palette
+static GColor *palette;
+
+static void set_glyph_color(GColor color) {
+  for (int level = 0; level < 4; level++) {
+    palette[level] = color;
+    palette[level].a = level;
+  }
+}
+#endif
+
+static int glyph_index(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  return c == ':' ? 10 : -1;
+}
+
+static GRect glyph_cell(int i) {
+  return GRect(i % GLYPH_COLUMNS * GLYPH_CELL_WIDTH, i / GLYPH_COLUMNS * GLYPH_CELL_HEIGHT,
+               GLYPH_CELL_WIDTH, GLYPH_CELL_HEIGHT);
+}
+
+// Until the atlas is rendered text is drawn with the font directly
+void glyph_atlas_init(GFont font) {
+  atlas_font = font;
+}
+
+// There is no offscreen context, so the glyphs are drawn white on black into
+// the frame at origin and copied out. The caller paints over that area afterwards.
+void glyph_atlas_render(GContext *ctx, GPoint origin) {
+  if (is_rendered || !atlas_font) {
+    return;
+  }
+  is_rendered = true;
+  GFont font = atlas_font;
+  
+  GRect area = { origin, GSize(GLYPH_ATLAS_WIDTH, GLYPH_ATLAS_HEIGHT) };
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, area, 0, GCornerNone);
+  graphics_context_set_text_color(ctx, GColorWhite);
+  char text[] = " ";
+  for (unsigned int i = 0; i < GLYPH_COUNT; i++) {
+    GRect cell = glyph_cell(i);
+    cell.origin.x += origin.x;
+    cell.origin.y += origin.y;
+    text[0] = GLYPH_CHARS[i];
+    graphics_draw_text(ctx, text, font, cell, GTextOverflowModeFill, GTextAlignmentLeft, NULL);
+    glyph_widths[i] = graphics_text_layout_get_content_size(text, font, cell, GTextOverflowModeFill, GTextAlignmentLeft).w;
+  }
+  
+  #ifdef PBL_COLOR
+  palette = malloc(4 * sizeof(GColor));
+  atlas = palette ? gbitmap_create_blank_with_palette(area.size, GBitmapFormat2BitPalette, palette, true) : NULL;
+  if (!atlas) {
+    free(palette);
+    palette = NULL;
+  }
+  #else
+  atlas = gbitmap_create_blank(area.size, GBitmapFormat1Bit);
+  #endif
+  GBitmap *frame = atlas ? graphics_capture_frame_buffer(ctx) : NULL;
+  if (!frame) {
+    // glyph_atlas_draw_text() keeps drawing text
+    glyph_atlas_destroy();
+    atlas_font = font;
+    is_rendered = true;
+    return;
+  }
+  
+  uint16_t row_size = gbitmap_get_bytes_per_row(atlas);
+  uint8_t *row = gbitmap_get_data(atlas);
+  for (int y = 0; y < GLYPH_ATLAS_HEIGHT; y++, row += row_size) {
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame, origin.y + y);
+    for (int x = 0; x < GLYPH_ATLAS_WIDTH; x++) {
+      int frame_x = origin.x + x;
+      if (frame_x < info.min_x || frame_x > info.max_x) {
+        continue;
+      }
+      #ifdef PBL_COLOR
+      // white text on black, any channel is the coverage
+      uint8_t level = ((GColor) { .argb = info.data[frame_x] }).r;
+      row[x / 4] |= level << (6 - x % 4 * 2);
+      #else
+      if (info.data[frame_x / 8] & (1 << frame_x % 8)) {
+        row[x / 8] |= 1 << x % 8;
+      }
+      #endif
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame);
+  
+  for (unsigned int i = 0; i < GLYPH_COUNT; i++) {
+    GRect cell = glyph_cell(i);
+    cell.size.w = glyph_widths[i];
+    glyphs[i] = gbitmap_create_as_sub_bitmap(atlas, cell);
+  }
+}
+
+// Draws text horizontally centered in box, characters outside the atlas are skipped
+void glyph_atlas_draw_text(GContext *ctx, const char *text, GRect box, GColor color) {
+  if (!atlas) {
+    if (atlas_font) {
+      graphics_context_set_text_color(ctx, color);
+      graphics_draw_text(ctx, text, atlas_font, box, GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+    }
+    return;
+  }
+  
+  int width = 0;
+  for (const char *c = text; *c; c++) {
+    int i = glyph_index(*c);
+    width += i < 0 ? 0 : glyph_widths[i];
+  }
+  
+  #ifdef PBL_COLOR
+  set_glyph_color(color);
+  graphics_context_set_compositing_mode(ctx, GCompOpSet);
+  #else
+  graphics_context_set_compositing_mode(ctx, gcolor_equal(color, GColorBlack) ? GCompOpClear : GCompOpOr);
+  #endif
+  int x = box.origin.x + (box.size.w - width) / 2;
+  for (const char *c = text; *c; c++) {
+    int i = glyph_index(*c);
+    if (i < 0) {
+      continue;
+    }
+    graphics_draw_bitmap_in_rect(ctx, glyphs[i], GRect(x, box.origin.y, glyph_widths[i], GLYPH_CELL_HEIGHT));
+    x += glyph_widths[i];
+  }
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+void glyph_atlas_destroy(void) {
+  for (unsigned int i = 0; i < GLYPH_COUNT; i++) {
+    if (glyphs[i]) {
+      gbitmap_destroy(glyphs[i]);
+      glyphs[i] = NULL;
+    }
+  }
+  if (atlas) {
+    // the atlas owns the palette
+    gbitmap_destroy(atlas);
+    atlas = NULL;
+  }
+  #ifdef PBL_COLOR
+  palette = NULL;
+  #endif
+  atlas_font = NULL;
+  is_rendered = false;
+}
@@ -0,0 +1,18 @@
+#include <pebble.h>
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+// Digits and ':' rasterized once from a font, then blitted instead of drawn as text
+#define GLYPH_ATLAS_WIDTH 84
+#define GLYPH_ATLAS_HEIGHT 48
+
+void glyph_atlas_init(GFont font);
+
+void glyph_atlas_render(GContext *ctx, GPoint origin);
+
+void glyph_atlas_draw_text(GContext *ctx, const char *text, GRect box, GColor color);
+
+void glyph_atlas_destroy(void);
+
+#endif /* GLYPH_ATLAS_H */
@@ -0,0 +1,45 @@
+#include <pebble.h>
+#include "handoff.h"
+#include "settings.h"
+#include "profile.h"
+
+// Another app may already own a wakeup slot within a minute of ours
+#define HANDOFF_RETRY_SHIFT 60
+
+void handoff_schedule(time_t deadline) {
+  // a period that ended while the app was closing is handed off for right away,
+  // the Wakeup API refuses times that have passed
+  deadline = MAX(deadline, time(NULL) + 1);
+  WakeupId id = wakeup_schedule(deadline, 0, true);
+  if (id == E_RANGE) {
+    id = wakeup_schedule(deadline + HANDOFF_RETRY_SHIFT, 0, true);
+  }
+  if (id < 0) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Wakeup not scheduled: %d", (int) id);
+    persist_delete(WAKEUP_ID_KEY);
+    return;
+  }
+  persist_write_int(WAKEUP_ID_KEY, id);
+  PROFILE_COUNT(PROFILE_PERSIST_WRITES, 1);
+  PROFILE_COUNT(PROFILE_PERSIST_BYTES, sizeof(int32_t));
+}
+
+// Takes the running session back from the Wakeup API, returns whether there was one
+bool handoff_resume(void) {
+  if (!persist_exists(WAKEUP_ID_KEY)) {
+    return false;
+  }
+  WakeupId id = persist_read_int(WAKEUP_ID_KEY);
+  persist_delete(WAKEUP_ID_KEY);
+  
+  if (launch_reason() == APP_LAUNCH_WAKEUP) {
+    return true;
+  }
+  
+  time_t timestamp;
+  if (wakeup_query(id, &timestamp)) {
+    wakeup_cancel(id);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,10 @@
+#include <pebble.h>
+
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+void handoff_schedule(time_t deadline);
+
+bool handoff_resume(void);
+
+#endif /* HANDOFF_H */
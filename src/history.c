@@ -0,0 +1,130 @@
+#include "history.h"
+#include "settings.h"
+#include "profile.h"
+
+#define COMPLETED_MAX 127
+#define SKIPPED_MAX 31
+#define LONG_BREAKS_MAX 15
+
+// Ring buffer of per-day counts, days[head] is the day numbered last_day
+typedef struct History {
+  uint8_t version;
+  uint8_t head;
+  uint16_t last_day;
+  HistoryDay days[HISTORY_DAYS];
+} __attribute__((__packed__)) History;
+
+static History history;
+static bool is_dirty;
+
+uint16_t history_day(time_t timestamp) {
+  struct tm *local = localtime(&timestamp);
+  return (timestamp + local->tm_gmtoff) / SECONDS_PER_DAY;
+}
+
+static void clear_history(uint16_t day) {
+  memset(&history, 0, sizeof(history));
+  history.version = HISTORY_VERSION;
+  history.last_day = day;
+}
+
+// Advances the ring to the given day, empty days in between are zeroed
+static HistoryDay *roll_to_day(uint16_t day) {
+  if (day > history.last_day) {
+    int gap = day - history.last_day;
+    if (gap >= HISTORY_DAYS) {
+      clear_history(day);
+    } else {
+      for (int i = 0; i < gap; i++) {
+        history.head = (history.head + 1) % HISTORY_DAYS;
+        history.days[history.head] = (HistoryDay) {};
+      }
+      history.last_day = day;
+    }
+    is_dirty = true;
+  }
+  // a clock moved backwards keeps counting into the latest day
+  return &history.days[history.head];
+}
+
+void load_history(void) {
+  PROFILE_BEGIN(PROFILE_PERSIST);
+  int read = persist_read_data(HISTORY_KEY, &history, sizeof(history));
+  PROFILE_END(PROFILE_PERSIST);
+  if (read != sizeof(history) || history.version != HISTORY_VERSION) {
+    clear_history(history_day(time(NULL)));
+  }
+  is_dirty = false;
+}
+
+void save_history(void) {
+  if (!is_dirty) {
+    return;
+  }
+  PROFILE_BEGIN(PROFILE_PERSIST);
+  persist_write_data(HISTORY_KEY, &history, sizeof(history));
+  PROFILE_END(PROFILE_PERSIST);
+  PROFILE_COUNT(PROFILE_PERSIST_WRITES, 1);
+  PROFILE_COUNT(PROFILE_PERSIST_BYTES, sizeof(history));
+  is_dirty = false;
+}
+
+void reset_history(void) {
+  persist_delete(HISTORY_KEY);
+  clear_history(history_day(time(NULL)));
+  is_dirty = false;
+}
+
+HistoryDay history_get(uint16_t day) {
+  int days_ago = history.last_day - day;
+  if (days_ago < 0 || days_ago >= HISTORY_DAYS) {
+    return (HistoryDay) {};
+  }
+  return history.days[(history.head + HISTORY_DAYS - days_ago) % HISTORY_DAYS];
+}
+
+HistoryDay history_get_day(time_t timestamp) {
+  return history_get(history_day(timestamp));
+}
+
+// Keeps the larger counts, for a day recovered from a checkpoint
+void history_merge_day(uint16_t day, HistoryDay counts) {
+  int days_ago = history.last_day - day;
+  if (days_ago >= HISTORY_DAYS) {
+    return;
+  }
+  HistoryDay *target = days_ago < 0 ? roll_to_day(day) :
+    &history.days[(history.head + HISTORY_DAYS - days_ago) % HISTORY_DAYS];
+  if (counts.completed > target->completed ||
+      counts.skipped > target->skipped ||
+      counts.long_breaks > target->long_breaks) {
+    target->completed = MAX(target->completed, counts.completed);
+    target->skipped = MAX(target->skipped, counts.skipped);
+    target->long_breaks = MAX(target->long_breaks, counts.long_breaks);
+    is_dirty = true;
+  }
+}
+
+void history_add_completed(time_t timestamp) {
+  HistoryDay *day = roll_to_day(history_day(timestamp));
+  if (day->completed < COMPLETED_MAX) {
+    day->completed++;
+    is_dirty = true;
+  }
+}
+
+void history_add_skipped(time_t timestamp) {
+  HistoryDay *day = roll_to_day(history_day(timestamp));
+  if (day->skipped < SKIPPED_MAX) {
+    day->skipped++;
+    is_dirty = true;
+  }
+}
+
+void history_add_long_break(time_t timestamp) {
+  HistoryDay *day = roll_to_day(history_day(timestamp));
+  if (day->long_breaks < LONG_BREAKS_MAX) {
+    day->long_breaks++;
+    is_dirty = true;
+  }
+}
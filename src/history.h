@@ -0,0 +1,35 @@
+#include <pebble.h>
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#define HISTORY_DAYS 120
+#define HISTORY_VERSION 1
+
+typedef struct HistoryDay {
+  uint16_t completed : 7;
+  uint16_t skipped : 5;
+  uint16_t long_breaks : 4;
+} __attribute__((__packed__)) HistoryDay;
+
+void load_history(void);
+
+void save_history(void);
+
+void reset_history(void);
+
+uint16_t history_day(time_t timestamp);
+
+HistoryDay history_get(uint16_t day);
+
+HistoryDay history_get_day(time_t timestamp);
+
+void history_merge_day(uint16_t day, HistoryDay counts);
+
+void history_add_completed(time_t timestamp);
+
+void history_add_skipped(time_t timestamp);
+
+void history_add_long_break(time_t timestamp);
+
+#endif /* HISTORY_H */
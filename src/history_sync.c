@@ -0,0 +1,214 @@
+#include <pebble.h>
+#include "history_sync.h"
+#include "history.h"
+#include "settings.h"
+#include "profile.h"
+
+// A whole 120-day history fits into one batch, so a daily sync is a single message
+#define SYNC_HEADER_BYTES 6
+#define SYNC_BATCH_BYTES (SYNC_HEADER_BYTES + HISTORY_DAYS * 3)
+#define SYNC_ACK_TIMEOUT 5000
+#define SYNC_MAX_RETRIES 3
+
+// Batch layout, little-endian:
+//   u8 version, u16 first day, u16 last day, u8 record count,
+//   then per non-empty day: varint day delta (from the previous record,
+//   the first one from first day) and the u16 packed HistoryDay.
+// Days between first and last day without a record are empty.
+
+static uint16_t synced_day;
+static uint16_t batch_last_day;
+static uint8_t seq;
+static bool is_in_flight;
+static int retries;
+static AppTimer *retry_timer;
+
+static uint16_t pack_day(HistoryDay day) {
+  return day.completed | day.skipped << 7 | day.long_breaks << 12;
+}
+
+static size_t write_varint(uint8_t *buffer, uint16_t value) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    buffer[size++] = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  buffer[size++] = value;
+  return size;
+}
+
+static void write_u16(uint8_t *buffer, uint16_t value) {
+  buffer[0] = value & 0xff;
+  buffer[1] = value >> 8;
+}
+
+static void save_synced_day(uint16_t day) {
+  synced_day = day;
+  persist_write_int(SYNC_DAY_KEY, day);
+  PROFILE_COUNT(PROFILE_PERSIST_WRITES, 1);
+  PROFILE_COUNT(PROFILE_PERSIST_BYTES, sizeof(int32_t));
+}
+
+static void send_batch(void);
+
+static void retry_callback(void *data) {
+  retry_timer = NULL;
+  is_in_flight = false;
+  if (retries++ < SYNC_MAX_RETRIES) {
+    send_batch();
+  }
+}
+
+// Waits for the phone, doubling the pause after every failed attempt
+static void arm_retry(void) {
+  uint32_t timeout = SYNC_ACK_TIMEOUT << retries;
+  if (retry_timer) {
+    app_timer_reschedule(retry_timer, timeout);
+  } else {
+    retry_timer = app_timer_register(timeout, retry_callback, NULL);
+  }
+}
+
+static void cancel_retry(void) {
+  if (retry_timer) {
+    app_timer_cancel(retry_timer);
+    retry_timer = NULL;
+  }
+}
+
+// Sends complete days after synced_day, today is still changing and waits for tomorrow
+static void send_batch(void) {
+  if (is_in_flight) {
+    return;
+  }
+  uint16_t today = history_day(time(NULL));
+  uint16_t first_day = MAX(synced_day + 1, today - HISTORY_DAYS);
+  if (first_day >= today) {
+    return;
+  }
+
+  uint8_t buffer[SYNC_BATCH_BYTES];
+  size_t size = SYNC_HEADER_BYTES;
+  uint8_t count = 0;
+  uint16_t previous = first_day;
+  uint16_t day;
+  for (day = first_day; day < today; day++) {
+    uint16_t packed = pack_day(history_get(day));
+    if (packed == 0) {
+      continue;
+    }
+    uint8_t record[5];
+    size_t record_size = write_varint(record, day - previous);
+    write_u16(record + record_size, packed);
+    record_size += 2;
+    if (size + record_size > sizeof(buffer) || count == UINT8_MAX) {
+      break;
+    }
+    memcpy(buffer + size, record, record_size);
+    size += record_size;
+    previous = day;
+    count++;
+  }
+  batch_last_day = day - 1;
+
+  // nothing but empty days, no need to wake the radio
+  if (count == 0) {
+    save_synced_day(batch_last_day);
+    return;
+  }
+
+  buffer[0] = SYNC_PROTOCOL_VERSION;
+  write_u16(buffer + 1, first_day);
+  write_u16(buffer + 3, batch_last_day);
+  buffer[5] = count;
+
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    arm_retry();
+    return;
+  }
+  dict_write_uint8(iter, SYNC_TYPE_KEY, SYNC_TYPE_BATCH);
+  dict_write_uint8(iter, SYNC_SEQ_KEY, seq);
+  dict_write_data(iter, SYNC_DATA_KEY, buffer, size);
+  if (app_message_outbox_send() != APP_MSG_OK) {
+    arm_retry();
+    return;
+  }
+  is_in_flight = true;
+  arm_retry();
+}
+
+static void inbox_received(DictionaryIterator *iter, void *context) {
+  Tuple *type = dict_find(iter, SYNC_TYPE_KEY);
+  if (!type) {
+    return;
+  }
+  switch (type->value->int32) {
+    case SYNC_TYPE_ACK: {
+      Tuple *ack_seq = dict_find(iter, SYNC_SEQ_KEY);
+      if (!is_in_flight || !ack_seq || (uint8_t) ack_seq->value->int32 != seq) {
+        return;
+      }
+      cancel_retry();
+      is_in_flight = false;
+      retries = 0;
+      seq++;
+      save_synced_day(batch_last_day);
+      send_batch();
+      break;
+    }
+    case SYNC_TYPE_REQUEST: {
+      // the phone reports what it holds, so lost data on its side is sent again
+      Tuple *last_day = dict_find(iter, SYNC_LAST_DAY_KEY);
+      if (last_day && last_day->value->int32 < synced_day) {
+        // the batch in flight starts after the lost days, its ack must not undo the rewind
+        if (is_in_flight) {
+          cancel_retry();
+          is_in_flight = false;
+          seq++;
+        }
+        save_synced_day(MAX(last_day->value->int32, 0));
+      }
+      retries = 0;
+      send_batch();
+      break;
+    }
+  }
+}
+
+static void outbox_failed(DictionaryIterator *iter, AppMessageResult reason, void *context) {
+  APP_LOG(APP_LOG_LEVEL_WARNING, "History batch not sent: %d", (int) reason);
+  arm_retry();
+}
+
+// A dropped link abandons the batch in flight, it is rebuilt from synced_day on reconnect
+static void connection_handler(bool connected) {
+  cancel_retry();
+  is_in_flight = false;
+  retries = 0;
+  if (connected) {
+    send_batch();
+  }
+}
+
+void history_sync_init(void) {
+  synced_day = persist_read_int(SYNC_DAY_KEY);
+
+  app_message_register_inbox_received(inbox_received);
+  app_message_register_outbox_failed(outbox_failed);
+  app_message_open(dict_calc_buffer_size(3, sizeof(int32_t), sizeof(int32_t), sizeof(int32_t)),
+                   dict_calc_buffer_size(3, sizeof(uint8_t), sizeof(uint8_t), SYNC_BATCH_BYTES));
+  connection_service_subscribe((ConnectionHandlers) {
+    .pebble_app_connection_handler = connection_handler
+  });
+
+  if (connection_service_peek_pebble_app_connection()) {
+    send_batch();
+  }
+}
+
+void history_sync_deinit(void) {
+  cancel_retry();
+  connection_service_unsubscribe();
+  app_message_deregister_callbacks();
+}
@@ -0,0 +1,23 @@
+#include <pebble.h>
+
+#ifndef HISTORY_SYNC_H
+#define HISTORY_SYNC_H
+
+// AppMessage keys, mirrored in appinfo.json appKeys
+#define SYNC_TYPE_KEY 0
+#define SYNC_SEQ_KEY 1
+#define SYNC_DATA_KEY 2
+#define SYNC_LAST_DAY_KEY 3
+
+// Message types carried in SYNC_TYPE_KEY
+#define SYNC_TYPE_BATCH 1
+#define SYNC_TYPE_ACK 2
+#define SYNC_TYPE_REQUEST 3
+
+#define SYNC_PROTOCOL_VERSION 1
+
+void history_sync_init(void);
+
+void history_sync_deinit(void);
+
+#endif /* HISTORY_SYNC_H */
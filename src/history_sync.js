@@ -0,0 +1,116 @@
+// Receiver for the watch history export, see history_sync.c for the batch layout
+
+var SYNC_PROTOCOL_VERSION = 1;
+var SYNC_TYPE_BATCH = 1;
+var SYNC_TYPE_ACK = 2;
+var SYNC_TYPE_REQUEST = 3;
+var SECONDS_PER_DAY = 86400;
+
+var STORAGE_HISTORY = 'history';
+var STORAGE_LAST_DAY = 'historyLastDay';
+
+// Decodes one batch into {firstDay, lastDay, days: [{day, completed, skipped, longBreaks}]},
+// returns null for a malformed batch
+function decodeHistoryBatch(bytes) {
+  if (bytes.length < 6 || bytes[0] !== SYNC_PROTOCOL_VERSION) {
+    return null;
+  }
+  var firstDay = bytes[1] | bytes[2] << 8;
+  var lastDay = bytes[3] | bytes[4] << 8;
+  var count = bytes[5];
+  var days = [];
+  var pos = 6;
+  var day = firstDay;
+  for (var i = 0; i < count; i++) {
+    var delta = 0;
+    var shift = 0;
+    var b;
+    do {
+      if (pos >= bytes.length) {
+        return null;
+      }
+      b = bytes[pos++];
+      delta |= (b & 0x7f) << shift;
+      shift += 7;
+    } while (b & 0x80);
+    if (pos + 2 > bytes.length) {
+      return null;
+    }
+    var packed = bytes[pos] | bytes[pos + 1] << 8;
+    pos += 2;
+    day += delta;
+    days.push({
+      day: day,
+      completed: packed & 0x7f,
+      skipped: packed >> 7 & 0x1f,
+      longBreaks: packed >> 12 & 0x0f
+    });
+  }
+  if (day > lastDay) {
+    return null;
+  }
+  return { firstDay: firstDay, lastDay: lastDay, days: days };
+}
+
+function dayToDate(day) {
+  return new Date(day * SECONDS_PER_DAY * 1000).toISOString().slice(0, 10);
+}
+
+function loadHistory() {
+  return JSON.parse(localStorage.getItem(STORAGE_HISTORY) || '{}');
+}
+
+function lastSyncedDay() {
+  return parseInt(localStorage.getItem(STORAGE_LAST_DAY) || '0', 10);
+}
+
+// Stores a batch, replays of an already stored batch are harmless
+function storeHistoryBatch(batch) {
+  var history = loadHistory();
+  batch.days.forEach(function(entry) {
+    history[dayToDate(entry.day)] = {
+      completed: entry.completed,
+      skipped: entry.skipped,
+      longBreaks: entry.longBreaks
+    };
+  });
+  localStorage.setItem(STORAGE_HISTORY, JSON.stringify(history));
+  localStorage.setItem(STORAGE_LAST_DAY, Math.max(lastSyncedDay(), batch.lastDay));
+}
+
+function handleHistoryMessage(payload, send) {
+  if (payload.SYNC_TYPE !== SYNC_TYPE_BATCH) {
+    return;
+  }
+  var batch = decodeHistoryBatch(payload.SYNC_DATA);
+  if (!batch) {
+    console.log('Malformed history batch ' + payload.SYNC_SEQ);
+    return;
+  }
+  storeHistoryBatch(batch);
+  send({ SYNC_TYPE: SYNC_TYPE_ACK, SYNC_SEQ: payload.SYNC_SEQ });
+}
+
+function sendToWatch(message) {
+  Pebble.sendAppMessage(message, null, function(e) {
+    console.log('History message not delivered: ' + JSON.stringify(e));
+  });
+}
+
+if (typeof Pebble !== 'undefined') {
+  Pebble.addEventListener('ready', function() {
+    sendToWatch({ SYNC_TYPE: SYNC_TYPE_REQUEST, SYNC_LAST_DAY: lastSyncedDay() });
+  });
+
+  Pebble.addEventListener('appmessage', function(e) {
+    handleHistoryMessage(e.payload, sendToWatch);
+  });
+}
+
+// Lets a local stand-in for the phone drive the decoder and the ack logic
+if (typeof module !== 'undefined') {
+  module.exports = {
+    decodeHistoryBatch: decodeHistoryBatch,
+    handleHistoryMessage: handleHistoryMessage
+  };
+}
@@ -1,8 +1,11 @@
 #include "iteration.h"
 #include <pebble.h>
-#include "settings.h"
+#include "history.h"
+#include "resource_cache.h"
+#include "profile.h"
 
-// BEGIN AUTO-GENERATED UI CODE; DO NOT MODIFY
+// Started out as generated UI code, edited by hand since its bitmaps and
+// fonts come from the resource cache, so it is no longer regenerated
 static Window *s_window;
 static GBitmap *s_res_image_count;
 static GFont s_res_font_roboto_70;
@@ -15,7 +18,6 @@ static void initialise_ui(void) {
   GRect bounds = layer_get_frame(window_layer);
   int window_width = bounds.size.w;
   int window_height = bounds.size.h;
-  int center_x = window_width / 2;
   int center_y = window_height / 2;
 
   window_set_background_color(s_window, PBL_IF_COLOR_ELSE(GColorDukeBlue, GColorBlack));
@@ -23,8 +25,6 @@ static void initialise_ui(void) {
     window_set_fullscreen(s_window, true);
   #endif
   
-  s_res_image_count = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_COUNT);
-  s_res_font_roboto_70 = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_ROBOTO_70));
   // s_backlayer
   s_backlayer = bitmap_layer_create(bounds);
   bitmap_layer_set_bitmap(s_backlayer, s_res_image_count);
@@ -34,7 +34,7 @@ static void initialise_ui(void) {
   layer_add_child(window_get_root_layer(s_window), (Layer *)s_backlayer);
   
   // s_count_layer
-  s_count_layer = text_layer_create(GRect(center_x - 48, center_y - 43, 100, 78));
+  s_count_layer = text_layer_create(GRect(0, center_y - 43, window_width, 78));
   text_layer_set_text_color(s_count_layer, PBL_IF_COLOR_ELSE(GColorWhite, GColorBlack));
   text_layer_set_background_color(s_count_layer, GColorClear);
   text_layer_set_text(s_count_layer, "0");
@@ -47,12 +47,19 @@ static void destroy_ui(void) {
   window_destroy(s_window);
   bitmap_layer_destroy(s_backlayer);
   text_layer_destroy(s_count_layer);
-  gbitmap_destroy(s_res_image_count);
-  fonts_unload_custom_font(s_res_font_roboto_70);
 }
-// END AUTO-GENERATED UI CODE
 
-static TomatoSettings settings;
+// Resources come from the shared cache, held for as long as the window exists
+static void acquire_resources(void) {
+  s_res_image_count = acquire_bitmap(RESOURCE_ID_IMAGE_COUNT);
+  s_res_font_roboto_70 = acquire_font(RESOURCE_ID_FONT_ROBOTO_70);
+}
+
+static void release_resources(void) {
+  release_bitmap(RESOURCE_ID_IMAGE_COUNT);
+  release_font(RESOURCE_ID_FONT_ROBOTO_70);
+}
+
 static AppTimer* close_timer;
 
 void hide_iteration(void) {
@@ -63,19 +70,16 @@ void hide_iteration(void) {
   window_stack_remove(s_window, true);
 }
 
-static void handle_window_unload(Window* window) {
-  destroy_ui();
-}
-
 void print_iteration_count() {
-    static char buffer[] = "99";
-    snprintf(buffer, sizeof("99"), "%d", settings.calendar.sets[0]);
+    // up to the 127 a history day can count
+    static char buffer[] = "127";
+    snprintf(buffer, sizeof(buffer), "%d", history_get_day(time(NULL)).completed);
     text_layer_set_text(s_count_layer, buffer);  
 }
 
 static void handle_iteration_window_appear(Window *window) {
-  settings = read_settings();  
   print_iteration_count();
+  PROFILE_END(PROFILE_WINDOW);
 }
 
 void iteration_select_click_handler(ClickRecognizerRef recognizer, void *context) {
@@ -87,18 +91,37 @@ void iteration_config_provider() {
 }
 
 void close_callback(void *data) {
+  close_timer = NULL;
   hide_iteration();
 }
 
+// The window is built on first use and kept, reopening only refreshes the count
 void show_iteration(void) {
-  initialise_ui();
-  window_set_click_config_provider(s_window, iteration_config_provider);
+  PROFILE_BEGIN(PROFILE_WINDOW);
+  if (!s_window) {
+    acquire_resources();
+    initialise_ui();
+    window_set_click_config_provider(s_window, iteration_config_provider);
+    window_set_window_handlers(s_window, (WindowHandlers) {
+      .appear = handle_iteration_window_appear
+    });
+  }
   
+  if (close_timer) {
+    app_timer_cancel(close_timer);
+  }
   close_timer = app_timer_register(5000, close_callback, NULL);
-  
-  window_set_window_handlers(s_window, (WindowHandlers) {
-    .unload = handle_window_unload,
-    .appear = handle_iteration_window_appear
-  });
   window_stack_push(s_window, true);
+}
+
+void iteration_deinit(void) {
+  if (close_timer) {
+    app_timer_cancel(close_timer);
+    close_timer = NULL;
+  }
+  if (s_window) {
+    destroy_ui();
+    release_resources();
+    s_window = NULL;
+  }
 }
\ No newline at end of file
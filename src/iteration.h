@@ -1,2 +1,3 @@
 void show_iteration(void);
 void hide_iteration(void);
+void iteration_deinit(void);
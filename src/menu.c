@@ -2,13 +2,15 @@
 #include "menu.h"
 #include "edit_number.h"
 #include "settings.h"
-  
-#define POMODORO_DURATION_ROW 0
-#define BREAK_DURATION_ROW 1
-#define LONG_BREAK_ENABLED_ROW 2
-#define LONG_BREAK_DURATION_ROW 3
-#define LONG_BREAK_DELAY_ROW 4
-#define RESET_ROW 5
+#include "history.h"
+#include "timers.h"
+#include "profile.h"
+
+#define TIMERS_SECTION 0
+#define SETTINGS_SECTION 1
+
+// The row after the last visible setting
+#define RESET_ROW SETTING_COUNT
 
 // BEGIN AUTO-GENERATED UI CODE; DO NOT MODIFY
 static Window *s_window;
@@ -38,93 +40,116 @@ static void destroy_ui(void) {
 }
 // END AUTO-GENERATED UI CODE
 
-static TomatoSettings settings;
+static TomatoSettings *settings;
+
+static bool is_row_visible(int setting) {
+  int parent = setting_params[setting].parent;
+  return parent == SETTING_NONE || settings->values[parent];
+}
 
+// Maps a menu row to its setting, skipping rows hidden by a disabled toggle
 int get_cell_row(MenuIndex *cell_index) {
   int row = cell_index->row;
-  if (!settings.long_break_enabled) {
-    if (row == LONG_BREAK_DURATION_ROW) {
-      row = RESET_ROW;
+  for (int setting = 0; setting < SETTING_COUNT; setting++) {
+    if (is_row_visible(setting) && row-- == 0) {
+      return setting;
     }
-  }  
-  return row;
+  }
+  return RESET_ROW;
+}
+
+static void draw_timer_row(GContext *ctx, Layer *cell_layer, int timer, char *description, size_t size) {
+  bool is_break;
+  int remaining = timers_remaining(timer, &is_break);
+  if (remaining < 0) {
+    strncpy(description, "Off", size);
+  } else {
+    snprintf(description, size, is_break ? "Break, %d min. left" : "%d min. left", (remaining + 59) / 60);
+  }
+  menu_cell_basic_draw(ctx, cell_layer, timers_get_preset(timer)->name, description, NULL);
 }
 
 void draw_row_callback(GContext *ctx, Layer *cell_layer, MenuIndex *cell_index, void *callback_context)
 {
   static char description[32];
-  switch(get_cell_row(cell_index)) {
-  case POMODORO_DURATION_ROW:
-    snprintf(description, sizeof(description), pomodoro_duration_params.format, settings.pomodoro_duration);
-    menu_cell_basic_draw(ctx, cell_layer, pomodoro_duration_params.title, description, NULL);
-    break;
-
-  case BREAK_DURATION_ROW:
-    snprintf(description, sizeof(description), break_duration_params.format, settings.break_duration);
-    menu_cell_basic_draw(ctx, cell_layer, break_duration_params.title, description, NULL);
-    break;
-
-  case LONG_BREAK_ENABLED_ROW:
-    menu_cell_basic_draw(ctx, cell_layer, long_break_enabled_params.title, settings.long_break_enabled ? "Enabled" : "Disabled", NULL);
-    break;
-
-  case LONG_BREAK_DURATION_ROW:
-    snprintf(description, sizeof(description), long_break_duration_params.format, settings.long_break_duration);
-    menu_cell_basic_draw(ctx, cell_layer, long_break_duration_params.title, description, NULL);
-    break;
-
-  case LONG_BREAK_DELAY_ROW:
-    snprintf(description, sizeof(description), long_break_delay_params.format, settings.long_break_delay);
-    menu_cell_basic_draw(ctx, cell_layer, long_break_delay_params.title, description, NULL);
-    break;
-
-  case RESET_ROW:
+  if (cell_index->section == TIMERS_SECTION) {
+    draw_timer_row(ctx, cell_layer, cell_index->row, description, sizeof(description));
+    return;
+  }
+  
+  int setting = get_cell_row(cell_index);
+  if (setting == RESET_ROW) {
     menu_cell_basic_draw(ctx, cell_layer, "Reset", NULL, NULL);
-    break;
+    return;
+  }
+  
+  const SettingParams *params = &setting_params[setting];
+  int value = settings->values[setting];
+  if (params->format) {
+    snprintf(description, sizeof(description), params->format, value);
+  } else {
+    strncpy(description, value ? "Enabled" : "Disabled", sizeof(description));
   }
+  menu_cell_basic_draw(ctx, cell_layer, params->title, description, NULL);
 }
  
+uint16_t num_sections_callback(MenuLayer *menu_layer, void *callback_context)
+{
+  return 2;
+}
+
+int16_t header_height_callback(MenuLayer *menu_layer, uint16_t section_index, void *callback_context)
+{
+  return MENU_CELL_BASIC_HEADER_HEIGHT;
+}
+
+void draw_header_callback(GContext *ctx, const Layer *cell_layer, uint16_t section_index, void *callback_context)
+{
+  menu_cell_basic_header_draw(ctx, cell_layer, section_index == TIMERS_SECTION ? "Timers" : "Settings");
+}
+
 uint16_t num_rows_callback(MenuLayer *menu_layer, uint16_t section_index, void *callback_context)
 {
-  return settings.long_break_enabled ? 6 : 4;
+  if (section_index == TIMERS_SECTION) {
+    return timers_count();
+  }
+  uint16_t rows = 1;
+  for (int setting = 0; setting < SETTING_COUNT; setting++) {
+    rows += is_row_visible(setting);
+  }
+  return rows;
 }
  
 void select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *callback_context)
 {
-  switch(get_cell_row(cell_index)) {
-  case POMODORO_DURATION_ROW:
-    show_edit_number(POMODORO_DURATION_KEY, settings.pomodoro_duration, pomodoro_duration_params);
-    break;
-
-  case BREAK_DURATION_ROW:
-    show_edit_number(BREAK_DURATION_KEY, settings.break_duration, break_duration_params);
-    break;
-
-  case LONG_BREAK_ENABLED_ROW:
-    settings.long_break_enabled = !settings.long_break_enabled;
-    persist_write_bool(LONG_BREAK_ENABLED_KEY, settings.long_break_enabled);
+  if (cell_index->section == TIMERS_SECTION) {
+    // the main window picks up the new deadline when it reappears
+    timers_toggle(cell_index->row);
     menu_layer_reload_data(menu_layer);
-    break;
-
-  case LONG_BREAK_DURATION_ROW:
-    show_edit_number(LONG_BREAK_DURATION_KEY, settings.long_break_duration, long_break_duration_params);
-    break;
-
-  case LONG_BREAK_DELAY_ROW:
-    show_edit_number(LONG_BREAK_DELAY_KEY, settings.long_break_delay, long_break_delay_params);
-    break;
-
-  case RESET_ROW:
+    return;
+  }
+  
+  int setting = get_cell_row(cell_index);
+  if (setting == RESET_ROW) {
     reset_settings();
+    reset_history();
+    reset_timers();
     window_stack_remove(s_window, true);
     menu_layer_reload_data(menu_layer);
-    break;
+  } else if (setting_params[setting].format) {
+    show_edit_number(setting, settings->values[setting], setting_params[setting]);
+  } else {
+    // toggles change memory only, the menu saves on disappear
+    settings->values[setting] = !settings->values[setting];
+    menu_layer_reload_data(menu_layer);
   }
-  
 }
 
 static void init_menu_callbacks() {
   MenuLayerCallbacks callbacks = {
+    .get_num_sections = (MenuLayerGetNumberOfSectionsCallback) num_sections_callback,
+    .get_header_height = (MenuLayerGetHeaderHeightCallback) header_height_callback,
+    .draw_header = (MenuLayerDrawHeaderCallback) draw_header_callback,
     .draw_row = (MenuLayerDrawRowCallback) draw_row_callback,
     .get_num_rows = (MenuLayerGetNumberOfRowsInSectionsCallback) num_rows_callback,
     .select_click = (MenuLayerSelectCallback) select_click_callback
@@ -132,27 +157,42 @@ static void init_menu_callbacks() {
   menu_layer_set_callbacks(s_menu_layer, NULL, callbacks);
 }
 
-static void handle_menu_window_unload(Window* window) {
-  destroy_ui();
-}
-
 static void handle_menu_window_appear(Window *window) {
-  settings = read_settings();  
   menu_layer_reload_data(s_menu_layer);
+  PROFILE_END(PROFILE_WINDOW);
+}
+
+static void handle_menu_window_disappear(Window *window) {
+  save_settings();
+  save_timers();
 }
 
+// The window is built on first use and kept, rows are reloaded when it appears
 void show_menu(void) {
-  initialise_ui();
-  
-  init_menu_callbacks();
+  PROFILE_BEGIN(PROFILE_WINDOW);
+  if (!s_window) {
+    settings = get_settings();
+    initialise_ui();
+    init_menu_callbacks();
+    window_set_window_handlers(s_window, (WindowHandlers) {
+      .appear = handle_menu_window_appear,
+      .disappear = handle_menu_window_disappear
+    });
+  }
   
-  window_set_window_handlers(s_window, (WindowHandlers) {
-    .unload = handle_menu_window_unload,
-    .appear = handle_menu_window_appear
-  });
+  // every visit starts from the top, as a freshly created menu did
+  menu_layer_set_selected_index(s_menu_layer, (MenuIndex) { 0, 0 }, MenuRowAlignNone, false);
   window_stack_push(s_window, true);
 }
 
 void hide_menu(void) {
   window_stack_remove(s_window, true);
 }
+
+void menu_deinit(void) {
+  edit_number_deinit();
+  if (s_window) {
+    destroy_ui();
+    s_window = NULL;
+  }
+}
@@ -1,2 +1,3 @@
 void show_menu(void);
 void hide_menu(void);
+void menu_deinit(void);
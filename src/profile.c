@@ -0,0 +1,122 @@
+#include "profile.h"
+
+#ifdef PROFILE
+
+// Bucket i counts samples below 2^i ms, the last one everything above
+typedef struct ProfileStats {
+  bool is_open;
+  uint32_t begin_ms;
+  uint32_t count;
+  uint32_t total_ms;
+  uint32_t max_ms;
+  uint16_t buckets[PROFILE_BUCKETS];
+} ProfileStats;
+
+static const char *const probe_names[PROFILE_PROBES] = {
+  "draw_scale",
+  "draw_countdown",
+  "tick",
+  "tick_latency",
+  "persist",
+  "window",
+  "launch"
+};
+
+static const char *const counter_names[PROFILE_COUNTERS] = {
+  "wakeups",
+  "redraws",
+  "persist_writes",
+  "persist_bytes",
+  "draw_ops"
+};
+
+static ProfileStats stats[PROFILE_PROBES];
+static uint32_t counters[PROFILE_COUNTERS];
+static time_t start_time;
+static size_t heap_high_water;
+
+static uint32_t now_ms(void) {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  return (uint32_t) seconds * 1000 + ms;
+}
+
+static void dump_callback(void *data) {
+  profile_dump();
+  app_timer_register(PROFILE_DUMP_INTERVAL * 1000, dump_callback, NULL);
+}
+
+void profile_init(void) {
+  memset(stats, 0, sizeof(stats));
+  memset(counters, 0, sizeof(counters));
+  start_time = time(NULL);
+  heap_high_water = heap_bytes_used();
+  app_timer_register(PROFILE_DUMP_INTERVAL * 1000, dump_callback, NULL);
+}
+
+void profile_begin(ProfileProbe probe) {
+  stats[probe].is_open = true;
+  stats[probe].begin_ms = now_ms();
+}
+
+// Only closes a begin still open, so an end on a window re-appearing after a
+// child closes is not timed against the push that opened the child
+void profile_end(ProfileProbe probe) {
+  if (!stats[probe].is_open) {
+    return;
+  }
+  stats[probe].is_open = false;
+  profile_value(probe, now_ms() - stats[probe].begin_ms);
+  profile_heap();
+}
+
+void profile_value(ProfileProbe probe, uint32_t ms) {
+  ProfileStats *probe_stats = &stats[probe];
+  int bucket = 0;
+  while (bucket < PROFILE_BUCKETS - 1 && ms >= (1u << bucket)) {
+    bucket++;
+  }
+  probe_stats->buckets[bucket]++;
+  probe_stats->count++;
+  probe_stats->total_ms += ms;
+  if (ms > probe_stats->max_ms) {
+    probe_stats->max_ms = ms;
+  }
+}
+
+void profile_heap(void) {
+  size_t used = heap_bytes_used();
+  if (used > heap_high_water) {
+    heap_high_water = used;
+  }
+}
+
+void profile_count(ProfileCounter counter, uint32_t amount) {
+  counters[counter] += amount;
+}
+
+void profile_dump(void) {
+  int elapsed = time(NULL) - start_time;
+  if (elapsed > 0) {
+    for (int i = 0; i < PROFILE_COUNTERS; i++) {
+      APP_LOG(APP_LOG_LEVEL_INFO, "%s total=%lu per_hour=%lu", counter_names[i],
+        (unsigned long) counters[i], (unsigned long) ((uint64_t) counters[i] * SECONDS_PER_HOUR / elapsed));
+    }
+  }
+  for (int i = 0; i < PROFILE_PROBES; i++) {
+    ProfileStats *probe_stats = &stats[i];
+    if (probe_stats->count == 0) {
+      continue;
+    }
+    uint16_t *b = probe_stats->buckets;
+    APP_LOG(APP_LOG_LEVEL_INFO, "%s n=%lu avg=%lums max=%lums hist=%u/%u/%u/%u/%u/%u/%u/%u",
+      probe_names[i], (unsigned long) probe_stats->count,
+      (unsigned long) (probe_stats->total_ms / probe_stats->count), (unsigned long) probe_stats->max_ms,
+      b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7]);
+  }
+  APP_LOG(APP_LOG_LEVEL_INFO, "heap used=%u high=%u free=%u",
+    (unsigned) heap_bytes_used(), (unsigned) heap_high_water, (unsigned) heap_bytes_free());
+}
+
+#endif /* PROFILE */
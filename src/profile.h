@@ -0,0 +1,63 @@
+#include <pebble.h>
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Build with `pebble build -- --profile` to compile the probes in,
+// without it every PROFILE_* macro expands to nothing
+#ifdef PROFILE
+
+#define PROFILE_DUMP_INTERVAL 60
+#define PROFILE_BUCKETS 8
+
+typedef enum ProfileProbe {
+  PROFILE_DRAW_SCALE,
+  // the break countdown, redrawn every second while a break runs
+  PROFILE_DRAW_COUNTDOWN,
+  PROFILE_TICK,
+  PROFILE_TICK_LATENCY,
+  PROFILE_PERSIST,
+  PROFILE_WINDOW,
+  PROFILE_LAUNCH,
+  PROFILE_PROBES
+} ProfileProbe;
+
+// Event counters, reported as rates per hour of running time
+typedef enum ProfileCounter {
+  PROFILE_WAKEUPS,
+  PROFILE_REDRAWS,
+  PROFILE_PERSIST_WRITES,
+  PROFILE_PERSIST_BYTES,
+  PROFILE_DRAW_OPS,
+  PROFILE_COUNTERS
+} ProfileCounter;
+
+void profile_init(void);
+void profile_begin(ProfileProbe probe);
+void profile_end(ProfileProbe probe);
+void profile_value(ProfileProbe probe, uint32_t ms);
+void profile_heap(void);
+void profile_count(ProfileCounter counter, uint32_t amount);
+void profile_dump(void);
+
+#define PROFILE_INIT() profile_init()
+#define PROFILE_BEGIN(probe) profile_begin(probe)
+#define PROFILE_END(probe) profile_end(probe)
+#define PROFILE_VALUE(probe, ms) profile_value(probe, ms)
+#define PROFILE_HEAP() profile_heap()
+#define PROFILE_COUNT(counter, amount) profile_count(counter, amount)
+#define PROFILE_DUMP() profile_dump()
+
+#else
+
+#define PROFILE_INIT()
+#define PROFILE_BEGIN(probe)
+#define PROFILE_END(probe)
+#define PROFILE_VALUE(probe, ms)
+#define PROFILE_HEAP()
+#define PROFILE_COUNT(counter, amount)
+#define PROFILE_DUMP()
+
+#endif /* PROFILE */
+
+#endif /* PROFILE_H */
@@ -0,0 +1,117 @@
+#include "resource_cache.h"
+
+typedef enum {
+  FONT_RESOURCE,
+  BITMAP_RESOURCE
+} ResourceType;
+
+typedef struct CachedResource {
+  uint32_t resource_id;
+  ResourceType type;
+  uint8_t refs;
+  void *data;
+} CachedResource;
+
+static CachedResource cache[RESOURCE_CACHE_SIZE];
+
+static void unload(CachedResource *entry) {
+  if (entry->type == FONT_RESOURCE) {
+    fonts_unload_custom_font((GFont) entry->data);
+  } else {
+    gbitmap_destroy((GBitmap*) entry->data);
+  }
+  entry->data = NULL;
+}
+
+// Unloads entries nobody holds, all of them when forced or only while the heap is short
+void trim_resources(bool force) {
+  for (int i = 0; i < RESOURCE_CACHE_SIZE; i++) {
+    if (!force && heap_bytes_free() >= RESOURCE_CACHE_MIN_FREE) {
+      return;
+    }
+    if (cache[i].data && cache[i].refs == 0) {
+      unload(&cache[i]);
+    }
+  }
+}
+
+static void *load(uint32_t resource_id, ResourceType type) {
+  return type == FONT_RESOURCE ?
+    (void*) fonts_load_custom_font(resource_get_handle(resource_id)) :
+    (void*) gbitmap_create_with_resource(resource_id);
+}
+
+static void *acquire(uint32_t resource_id, ResourceType type) {
+  CachedResource *free_entry = NULL;
+  for (int i = 0; i < RESOURCE_CACHE_SIZE; i++) {
+    CachedResource *entry = &cache[i];
+    if (entry->data && entry->resource_id == resource_id && entry->type == type) {
+      entry->refs++;
+      return entry->data;
+    }
+    if (!entry->data && !free_entry) {
+      free_entry = entry;
+    }
+  }
+  
+  trim_resources(false);
+  if (!free_entry) {
+    trim_resources(true);
+    for (int i = 0; i < RESOURCE_CACHE_SIZE && !free_entry; i++) {
+      if (!cache[i].data) {
+        free_entry = &cache[i];
+      }
+    }
+  }
+  if (!free_entry) {
+    // every entry is held, data loaded now would have no owner to release it
+    APP_LOG(APP_LOG_LEVEL_WARNING, "No cache entry for resource %d", (int) resource_id);
+    return NULL;
+  }
+  
+  void *data = load(resource_id, type);
+  if (!data) {
+    // unheld entries may still be taking the heap the load needs
+    trim_resources(true);
+    data = load(resource_id, type);
+  }
+  
+  if (data) {
+    *free_entry = (CachedResource) {
+      .resource_id = resource_id,
+      .type = type,
+      .refs = 1,
+      .data = data
+    };
+  }
+  return data;
+}
+
+static void release(uint32_t resource_id, ResourceType type) {
+  for (int i = 0; i < RESOURCE_CACHE_SIZE; i++) {
+    CachedResource *entry = &cache[i];
+    if (entry->data && entry->resource_id == resource_id && entry->type == type) {
+      if (entry->refs > 0) {
+        entry->refs--;
+      }
+      break;
+    }
+  }
+  trim_resources(false);
+}
+
+GFont acquire_font(uint32_t resource_id) {
+  return (GFont) acquire(resource_id, FONT_RESOURCE);
+}
+
+void release_font(uint32_t resource_id) {
+  release(resource_id, FONT_RESOURCE);
+}
+
+GBitmap *acquire_bitmap(uint32_t resource_id) {
+  return (GBitmap*) acquire(resource_id, BITMAP_RESOURCE);
+}
+
+void release_bitmap(uint32_t resource_id) {
+  release(resource_id, BITMAP_RESOURCE);
+}
@@ -0,0 +1,18 @@
+#include <pebble.h>
+
+#ifndef RESOURCE_CACHE_H
+#define RESOURCE_CACHE_H
+
+// Entries nobody holds are kept for reuse while at least this much heap is free
+#define RESOURCE_CACHE_MIN_FREE 8192
+#define RESOURCE_CACHE_SIZE 10
+
+GFont acquire_font(uint32_t resource_id);
+void release_font(uint32_t resource_id);
+
+GBitmap *acquire_bitmap(uint32_t resource_id);
+void release_bitmap(uint32_t resource_id);
+
+void trim_resources(bool force);
+
+#endif /* RESOURCE_CACHE_H */
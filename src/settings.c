@@ -1,41 +1,22 @@
 #include "settings.h"
+#include "profile.h"
 
-const SettingParams pomodoro_duration_params = {
-    .default_value = 25,
-    .min_value = 1,
-    .max_value = 60,
-    .title = "Pomodoro Duration",
-    .format = "%u min."
-};
-
-const SettingParams break_duration_params = {
-    .default_value = 5,
-    .min_value = 1,
-    .max_value = 30,
-    .title = "Break Duration",
-    .format = "%u min."
-};
+#define SETTING_PARAMS(id, field, parent_id, key_, default_, min_, max_, title_, format_) \
+  [SETTING_##id] = { \
+    .key = key_, \
+    .parent = SETTING_##parent_id, \
+    .default_value = default_, \
+    .min_value = min_, \
+    .max_value = max_, \
+    .title = title_, \
+    .format = format_ \
+  },
 
-const SettingParams long_break_enabled_params = {
-    .default_value = true,
-    .title = "Long Break"
+const SettingParams setting_params[SETTING_COUNT] = {
+  SETTINGS_TABLE(SETTING_PARAMS)
 };
 
-const SettingParams long_break_duration_params = {
-    .default_value = 15,
-    .min_value = 1,
-    .max_value = 60,
-    .title = "Long Break Duration",
-    .format = "%u min."
-};
-
-const SettingParams long_break_delay_params = {
-    .default_value = 4,
-    .min_value = 2,
-    .max_value = 9,
-    .title = "Long Break Delay",
-    .format = "%u"
-};
+#undef SETTING_PARAMS
 
 int32_t read_int(const uint32_t key, int32_t def_value) {
   if (persist_exists(key)) {
@@ -53,78 +34,142 @@ bool read_bool(const uint32_t key, int32_t def_value) {
   }
 }
 
-Calendar read_calendar(const uint32_t key, Calendar def_value) {
-  if (persist_exists(key)) {
-    Calendar calendar;
-    persist_read_data(key, &calendar, sizeof(calendar));
-    return calendar;
-  } else {
-    return def_value;
-  }
-}
+typedef struct SettingsBlob {
+  uint8_t version;
+  TomatoSettings settings;
+} SettingsBlob;
+
+// The one in-memory copy, loaded at startup and shared by all windows
+static TomatoSettings settings;
+
+// Last written blob, saves that would not change it are skipped
+static SettingsBlob saved_blob;
+
+// Set by reset_settings until the main window has dropped its session state
+static bool is_reset;
 
 TomatoSettings get_default_settings() {
   TomatoSettings default_settings = {
-    .last_time = time(NULL),
-    .state = STATE_DEFAULT,
-    .current_duration = pomodoro_duration_params.default_value * 60,
-    .calendar = CALENDAR_DEFAULT,
-    .pomodoro_duration = pomodoro_duration_params.default_value,
-    .break_duration = break_duration_params.default_value,
-    .long_break_enabled = long_break_enabled_params.default_value,
-    .long_break_duration = long_break_duration_params.default_value,
-    .long_break_delay = long_break_delay_params.default_value
+    .state = STATE_DEFAULT
   };
+  for (int i = 0; i < SETTING_COUNT; i++) {
+    default_settings.values[i] = setting_params[i].default_value;
+  }
+  default_settings.end_time = time(NULL) + default_settings.pomodoro_duration * 60;
   
   return default_settings;
 }
 
-TomatoSettings read_settings() {
-  TomatoSettings default_settings = get_default_settings();
-  
+static TomatoSettings read_legacy_settings(TomatoSettings default_settings) {
   TomatoSettings settings = {
-    .last_time = read_int(LAST_TIME_KEY, default_settings.last_time),
-    .state = read_int(STATE_KEY, default_settings.state),
-    .current_duration = read_int(CURRENT_DURATION_KEY, default_settings.current_duration),
-    .calendar = read_calendar(CALENDAR_KEY, default_settings.calendar),
-    .pomodoro_duration = read_int(POMODORO_DURATION_KEY, default_settings.pomodoro_duration),
-    .break_duration = read_int(BREAK_DURATION_KEY, default_settings.break_duration),
-    .long_break_enabled = read_bool(LONG_BREAK_ENABLED_KEY, default_settings.long_break_enabled),
-    .long_break_duration = read_int(LONG_BREAK_DURATION_KEY, default_settings.long_break_duration),
-    .long_break_delay = read_int(LONG_BREAK_DELAY_KEY, default_settings.long_break_delay),
+    .end_time = persist_exists(LAST_TIME_KEY) ?
+      read_int(LAST_TIME_KEY, 0) + read_int(CURRENT_DURATION_KEY, 0) :
+      default_settings.end_time,
+    .state = read_int(STATE_KEY, default_settings.state)
   };
-  
-  int time_passed = default_settings.last_time - settings.last_time;
+  for (int i = 0; i < SETTING_COUNT; i++) {
+    const SettingParams *params = &setting_params[i];
+    if (params->key == NO_LEGACY_KEY) {
+      settings.values[i] = params->default_value;
+      continue;
+    }
+    settings.values[i] = params->format ?
+      read_int(params->key, params->default_value) :
+      read_bool(params->key, params->default_value);
+  }
+  return settings;
+}
 
-  if (time_passed > MAX_ITERATION_IDLE) {
-    settings.calendar = default_settings.calendar;
+static void delete_legacy_settings(void) {
+  persist_delete(LAST_TIME_KEY);
+  persist_delete(STATE_KEY);
+  persist_delete(CURRENT_DURATION_KEY);
+  persist_delete(CALENDAR_KEY);
+  for (int i = 0; i < SETTING_COUNT; i++) {
+    if (setting_params[i].key != NO_LEGACY_KEY) {
+      persist_delete(setting_params[i].key);
+    }
   }
+}
+
+// Out-of-range values from a damaged or older blob fall back to defaults
+static void validate_settings(void) {
+  for (int i = 0; i < SETTING_COUNT; i++) {
+    const SettingParams *params = &setting_params[i];
+    if (settings.values[i] < params->min_value || settings.values[i] > params->max_value) {
+      settings.values[i] = params->default_value;
+    }
+  }
+}
+
+void load_settings(void) {
+  TomatoSettings default_settings = get_default_settings();
+  
+  SettingsBlob blob;
+  PROFILE_BEGIN(PROFILE_PERSIST);
+  int read = persist_read_data(SETTINGS_KEY, &blob, sizeof(blob));
+  PROFILE_END(PROFILE_PERSIST);
+  if (read == sizeof(blob) && blob.version == SETTINGS_VERSION) {
+    saved_blob = blob;
+    settings = blob.settings;
+  } else if (persist_exists(LAST_TIME_KEY) || persist_exists(POMODORO_DURATION_KEY)) {
+    // settings from before the blob format are migrated once
+    settings = read_legacy_settings(default_settings);
+    save_settings();
+    delete_legacy_settings();
+  } else {
+    settings = default_settings;
+  }
+  validate_settings();
+}
+
+TomatoSettings *get_settings(void) {
+  return &settings;
+}
+
+void expire_session(void) {
+  TomatoSettings default_settings = get_default_settings();
   
-  if (time_passed > MAX_APP_IDLE) {
-    settings.last_time = default_settings.last_time;
+  if (time(NULL) - settings.end_time > MAX_APP_IDLE) {
+    settings.end_time = default_settings.end_time;
     settings.state = default_settings.state;
-    settings.current_duration = default_settings.current_duration;
   }
+}
+
+void save_settings(void) {
+  SettingsBlob blob;
+  memset(&blob, 0, sizeof(blob));
+  blob.version = SETTINGS_VERSION;
+  blob.settings = settings;
+  // the running period is checkpointed on its own, see checkpoint.c
+  blob.settings.end_time = 0;
+  blob.settings.state = 0;
   
-  return settings;
+  if (memcmp(&blob, &saved_blob, sizeof(blob)) == 0) {
+    return;
+  }
+  PROFILE_BEGIN(PROFILE_PERSIST);
+  persist_write_data(SETTINGS_KEY, &blob, sizeof(blob));
+  PROFILE_END(PROFILE_PERSIST);
+  PROFILE_COUNT(PROFILE_PERSIST_WRITES, 1);
+  PROFILE_COUNT(PROFILE_PERSIST_BYTES, sizeof(blob));
+  saved_blob = blob;
 }
 
-void save_settings(TomatoSettings settings) {
-  persist_write_int(LAST_TIME_KEY, settings.last_time);
-  persist_write_int(STATE_KEY, settings.state);
-  persist_write_int(CURRENT_DURATION_KEY, settings.current_duration);
-  Calendar calendar = settings.calendar;
-  persist_write_data(CALENDAR_KEY, &calendar, sizeof(calendar));
+void set_setting_value(int setting, int value) {
+  settings.values[setting] = value;
 }
 
 void reset_settings(void) {
-  persist_delete(LAST_TIME_KEY);
-  persist_delete(STATE_KEY);
-  persist_delete(CURRENT_DURATION_KEY);
-  persist_delete(CALENDAR_KEY);
-  persist_delete(POMODORO_DURATION_KEY);
-  persist_delete(BREAK_DURATION_KEY);
-  persist_delete(LONG_BREAK_ENABLED_KEY);
-  persist_delete(LONG_BREAK_DURATION_KEY);
-  persist_delete(LONG_BREAK_DELAY_KEY);
+  persist_delete(SETTINGS_KEY);
+  delete_legacy_settings();
+  memset(&saved_blob, 0, sizeof(saved_blob));
+  settings = get_default_settings();
+  is_reset = true;
+}
+
+bool take_settings_reset(void) {
+  bool was_reset = is_reset;
+  is_reset = false;
+  return was_reset;
 }
\ No newline at end of file
@@ -5,7 +5,8 @@
 #define PAUSED_EXEC_STATE 1
   
 #define MAX_APP_IDLE (30 * 60)
-#define MAX_ITERATION_IDLE (8 * 60 * 60)
+#define LOW_POWER_IDLE 30
+#define APP_EXIT_IDLE (5 * 60)
 
 #define INCREMENT_TIME 60
 
@@ -19,17 +20,53 @@
 #define LONG_BREAK_ENABLED_KEY 6
 #define LONG_BREAK_DURATION_KEY 7
 #define LONG_BREAK_DELAY_KEY 8
+#define WAKEUP_ID_KEY 9
+#define SETTINGS_KEY 10
+#define HISTORY_KEY 11
+#define SYNC_DAY_KEY 12
+#define TIMERS_KEY 13
+// two keys, checkpoints alternate between them
+#define CHECKPOINT_KEY 14
+// for settings added with the blob, they were never stored on their own
+#define NO_LEGACY_KEY UINT8_MAX
+
+#define SETTINGS_VERSION 4
 
-#define LAST_TIME_DEFAULT 0
 #define STATE_DEFAULT 0
-#define CALENDAR_DEFAULT ((Calendar){time(NULL), {}})
   
 #include "pebble.h"
   
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
+// One row per user setting, storage, defaults, loading and menu rows are
+// generated from it. Settings with a NULL format are on/off toggles, a
+// parent other than NONE hides the row while that toggle is off. The
+// legacy key is where the setting was kept before the blob format.
+//
+//   X(ID, field, parent, legacy key, default, min, max, title, format)
+#define SETTINGS_TABLE(X) \
+  X(POMODORO_DURATION, pomodoro_duration, NONE, POMODORO_DURATION_KEY, 25, 1, 60, "Pomodoro Duration", "%u min.") \
+  X(BREAK_DURATION, break_duration, NONE, BREAK_DURATION_KEY, 5, 1, 30, "Break Duration", "%u min.") \
+  X(LONG_BREAK_ENABLED, long_break_enabled, NONE, LONG_BREAK_ENABLED_KEY, true, false, true, "Long Break", NULL) \
+  X(LONG_BREAK_DURATION, long_break_duration, LONG_BREAK_ENABLED, LONG_BREAK_DURATION_KEY, 15, 1, 60, \
+    "Long Break Duration", "%u min.") \
+  X(LONG_BREAK_DELAY, long_break_delay, LONG_BREAK_ENABLED, LONG_BREAK_DELAY_KEY, 4, 2, 9, "Long Break Delay", "%u") \
+  X(TEA_DURATION, tea_duration, NONE, NO_LEGACY_KEY, 4, 1, 60, "Tea Timer", "%u min.") \
+  X(STAND_UP_DURATION, stand_up_duration, NONE, NO_LEGACY_KEY, 15, 1, 60, "Stand-up Timer", "%u min.") \
+  X(EYE_REST_DURATION, eye_rest_duration, NONE, NO_LEGACY_KEY, 20, 1, 60, "Eye Rest Timer", "%u min.")
+
+#define SETTING_ENUM(id, ...) SETTING_##id,
+enum {
+  SETTING_NONE = -1,
+  SETTINGS_TABLE(SETTING_ENUM)
+  SETTING_COUNT
+};
+#undef SETTING_ENUM
+
 typedef struct SettingParams {
+  uint8_t key;
+  int8_t parent;
   int default_value;
   int min_value;
   int max_value;
@@ -37,35 +74,37 @@ typedef struct SettingParams {
   char* format;
 } SettingParams;
 
-extern const SettingParams pomodoro_duration_params;
-extern const SettingParams break_duration_params;
-extern const SettingParams long_break_enabled_params;
-extern const SettingParams long_break_duration_params;
-extern const SettingParams long_break_delay_params;
-
-typedef struct Calendar {
-  int start_time;
-  uint8_t sets[100];
-} __attribute__((__packed__)) Calendar;
+extern const SettingParams setting_params[SETTING_COUNT];
 
 typedef struct TomatoSettings {
-  int last_time;
+  int end_time;
   int state;
-  int current_duration;
-  Calendar calendar;
-  int pomodoro_duration;
-  int break_duration;
-  bool long_break_enabled;
-  int long_break_duration;
-  int long_break_delay;
+  // every setting is reachable by name and by its SETTING_ index
+  union {
+    struct {
+      #define SETTING_FIELD(id, field, ...) int field;
+      SETTINGS_TABLE(SETTING_FIELD)
+      #undef SETTING_FIELD
+    };
+    int values[SETTING_COUNT];
+  };
 } TomatoSettings;
 
 TomatoSettings get_default_settings();
 
-TomatoSettings read_settings();
+void load_settings(void);
 
-void save_settings(TomatoSettings settings);
+TomatoSettings *get_settings(void);
+
+void save_settings(void);
+
+void set_setting_value(int setting, int value);
+
+void expire_session(void);
 
 void reset_settings(void);
 
+// True once after reset_settings, so the main window can clear a pause
+bool take_settings_reset(void);
+
 #endif /* SETTINGS_H */
\ No newline at end of file
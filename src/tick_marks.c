@@ -0,0 +1,64 @@
+#include <pebble.h>
+#include "tick_marks.h"
+
+// Marks are filled straight into the frame buffer, one byte per pixel on
+// color and one bit per pixel (least significant first) on aplite
+#ifdef PBL_COLOR
+static const uint8_t tick_pixels[2] = { GColorWhiteARGB8, GColorLightGrayARGB8 };
+
+static void fill_span(GBitmapDataRowInfo row, int from, int to, uint8_t pixel) {
+  memset(row.data + from, pixel, to - from);
+}
+#else
+static const uint8_t tick_pixels[2] = { 0, 0 };
+
+static void fill_span(GBitmapDataRowInfo row, int from, int to, uint8_t pixel) {
+  for (int x = from; x < to; x++) {
+    if (pixel) {
+      row.data[x / 8] |= 1 << x % 8;
+    } else {
+      row.data[x / 8] &= ~(1 << x % 8);
+    }
+  }
+}
+#endif
+
+// Same pixels as a stroked rect TICK_MARK_WIDTH wide, used when the frame buffer is unavailable
+static void draw_with_context(GContext *ctx, GSize size, const TickMark *marks, int count) {
+  for (int i = 0; i < count; i++) {
+    graphics_context_set_fill_color(ctx, marks[i].is_faded ? TICK_FADED_COLOR : TICK_COLOR);
+    graphics_fill_rect(ctx, GRect(marks[i].x, marks[i].top, TICK_MARK_WIDTH, size.h - marks[i].top),
+                       0, GCornerNone);
+  }
+}
+
+void tick_marks_draw(GContext *ctx, Layer *layer, const TickMark *marks, int count) {
+  GSize size = layer_get_bounds(layer).size;
+  GBitmap *frame = graphics_capture_frame_buffer(ctx);
+  if (!frame) {
+    draw_with_context(ctx, size, marks, count);
+    return;
+  }
+  
+  GPoint origin = layer_convert_point_to_screen(layer, GPointZero);
+  int frame_height = gbitmap_get_bounds(frame).size.h;
+  for (int i = 0; i < count; i++) {
+    // clipped to the layer first, then to what the row holds on screen
+    int from = origin.x + MAX(marks[i].x, 0);
+    int to = origin.x + MIN(marks[i].x + TICK_MARK_WIDTH, size.w);
+    uint8_t pixel = tick_pixels[marks[i].is_faded];
+    for (int y = marks[i].top; y < size.h; y++) {
+      int screen_y = origin.y + y;
+      if (screen_y < 0 || screen_y >= frame_height) {
+        continue;
+      }
+      GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame, screen_y);
+      int row_from = MAX(from, row.min_x);
+      int row_to = MIN(to, row.max_x + 1);
+      if (row_from < row_to) {
+        fill_span(row, row_from, row_to, pixel);
+      }
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame);
+}
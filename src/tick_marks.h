@@ -0,0 +1,19 @@
+#include <pebble.h>
+
+#ifndef TICK_MARKS_H
+#define TICK_MARKS_H
+
+#define TICK_MARK_WIDTH 2
+#define TICK_COLOR PBL_IF_COLOR_ELSE(GColorWhite, GColorBlack)
+#define TICK_FADED_COLOR PBL_IF_COLOR_ELSE(GColorLightGray, GColorBlack)
+
+// Column x (left edge) from row top down to the bottom of the layer
+typedef struct TickMark {
+  int16_t x;
+  uint8_t top;
+  bool is_faded;
+} TickMark;
+
+void tick_marks_draw(GContext *ctx, Layer *layer, const TickMark *marks, int count);
+
+#endif /* TICK_MARKS_H */
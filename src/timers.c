@@ -0,0 +1,135 @@
+#include "timers.h"
+#include "deadline_queue.h"
+#include "settings.h"
+#include "profile.h"
+
+#define TIMER_OFF 0
+#define TIMER_RUNNING 1
+#define TIMER_BREAK 2
+
+static const TimerPreset presets[] = {
+  { .name = "Tea", .setting = SETTING_TEA_DURATION },
+  { .name = "Stand-up", .setting = SETTING_STAND_UP_DURATION },
+  { .name = "Eye Rest", .setting = SETTING_EYE_REST_DURATION, .break_duration = 20 }
+};
+
+#define TIMER_COUNT ARRAY_LENGTH(presets)
+
+typedef struct TimerState {
+  int32_t end_time;
+  uint8_t state;
+} __attribute__((__packed__)) TimerState;
+
+typedef struct TimersBlob {
+  uint8_t version;
+  TimerState timers[TIMER_COUNT];
+} __attribute__((__packed__)) TimersBlob;
+
+static TimersBlob blob;
+static bool is_dirty;
+
+static uint8_t queue_id(int timer) {
+  return TIMER_MAIN + 1 + timer;
+}
+
+static void set_timer(int timer, uint8_t state, time_t end_time) {
+  blob.timers[timer].state = state;
+  blob.timers[timer].end_time = end_time;
+  if (state == TIMER_OFF) {
+    deadline_queue_remove(queue_id(timer));
+  } else {
+    deadline_queue_set(queue_id(timer), end_time);
+  }
+  // every change is a start, stop or transition, so it is written right away
+  is_dirty = true;
+  save_timers();
+}
+
+static int preset_duration(const TimerPreset *preset) {
+  return get_settings()->values[preset->setting] * 60;
+}
+
+int timers_count(void) {
+  return TIMER_COUNT;
+}
+
+const TimerPreset *timers_get_preset(int timer) {
+  return &presets[timer];
+}
+
+// Seconds left, or -1 for a timer that is not running
+int timers_remaining(int timer, bool *is_break) {
+  TimerState *state = &blob.timers[timer];
+  if (state->state == TIMER_OFF) {
+    return -1;
+  }
+  *is_break = state->state == TIMER_BREAK;
+  int remaining = state->end_time - time(NULL);
+  return remaining < 0 ? 0 : remaining;
+}
+
+void timers_toggle(int timer) {
+  if (blob.timers[timer].state == TIMER_OFF) {
+    set_timer(timer, TIMER_RUNNING, time(NULL) + preset_duration(&presets[timer]));
+  } else {
+    set_timer(timer, TIMER_OFF, 0);
+  }
+}
+
+// Called for a named timer whose deadline has passed, it was already taken off the queue
+void timers_fire(uint8_t id, time_t now) {
+  int timer = id - TIMER_MAIN - 1;
+  if (timer < 0 || timer >= (int) TIMER_COUNT) {
+    return;
+  }
+  const TimerPreset *preset = &presets[timer];
+  if (preset->break_duration == 0) {
+    set_timer(timer, TIMER_OFF, 0);
+    vibes_long_pulse();
+  } else if (blob.timers[timer].state == TIMER_RUNNING) {
+    set_timer(timer, TIMER_BREAK, now + preset->break_duration);
+    vibes_short_pulse();
+  } else {
+    set_timer(timer, TIMER_RUNNING, now + preset_duration(preset));
+    vibes_double_pulse();
+  }
+  light_enable_interaction();
+}
+
+void load_timers(void) {
+  PROFILE_BEGIN(PROFILE_PERSIST);
+  int read = persist_read_data(TIMERS_KEY, &blob, sizeof(blob));
+  PROFILE_END(PROFILE_PERSIST);
+  if (read != sizeof(blob) || blob.version != TIMERS_VERSION) {
+    memset(&blob, 0, sizeof(blob));
+    blob.version = TIMERS_VERSION;
+  }
+  for (unsigned int timer = 0; timer < TIMER_COUNT; timer++) {
+    if (blob.timers[timer].state != TIMER_OFF) {
+      deadline_queue_set(queue_id(timer), blob.timers[timer].end_time);
+    }
+  }
+  is_dirty = false;
+}
+
+void save_timers(void) {
+  if (!is_dirty) {
+    return;
+  }
+  PROFILE_BEGIN(PROFILE_PERSIST);
+  persist_write_data(TIMERS_KEY, &blob, sizeof(blob));
+  PROFILE_END(PROFILE_PERSIST);
+  PROFILE_COUNT(PROFILE_PERSIST_WRITES, 1);
+  PROFILE_COUNT(PROFILE_PERSIST_BYTES, sizeof(blob));
+  is_dirty = false;
+}
+
+void reset_timers(void) {
+  for (unsigned int timer = 0; timer < TIMER_COUNT; timer++) {
+    deadline_queue_remove(queue_id(timer));
+  }
+  persist_delete(TIMERS_KEY);
+  memset(&blob, 0, sizeof(blob));
+  blob.version = TIMERS_VERSION;
+  is_dirty = false;
+}
@@ -0,0 +1,34 @@
+#include <pebble.h>
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+// Deadline queue id of the pomodoro timer, the named timers follow it
+#define TIMER_MAIN 0
+#define TIMERS_VERSION 1
+
+typedef struct TimerPreset {
+  char *name;
+  // the SETTING_ index of the duration in minutes, edited from the menu
+  int8_t setting;
+  // seconds, zero for a one-shot timer, otherwise the timer cycles like the pomodoro one
+  uint16_t break_duration;
+} TimerPreset;
+
+int timers_count(void);
+
+const TimerPreset *timers_get_preset(int timer);
+
+int timers_remaining(int timer, bool *is_break);
+
+void timers_toggle(int timer);
+
+void timers_fire(uint8_t id, time_t now);
+
+void load_timers(void);
+
+void save_timers(void);
+
+void reset_timers(void);
+
+#endif /* TIMERS_H */
@@ -2,7 +2,25 @@
 #include "settings.h"
 #include "menu.h"
 #include "iteration.h"
+#include "handoff.h"
+#include "history.h"
+#include "history_sync.h"
+#include "deadline_queue.h"
+#include "timers.h"
+#include "checkpoint.h"
+#include "resource_cache.h"
+#include "glyph_atlas.h"
+#include "tick_marks.h"
+#include "background.h"
+#include "profile.h"
   
+#define BACKGROUND_COLOR PBL_IF_COLOR_ELSE(GColorDukeBlue, GColorBlack)
+
+#define SCALE_WIDTH 140
+#define SCALE_HEIGHT 35
+// Minutes drawn past each end of the hour so the scale never runs out while warped
+#define SCALE_MARGIN_MINUTES 10
+
 static Window *window;
 
 static BitmapLayer *work_layer;
@@ -11,26 +29,31 @@ static BitmapLayer *relax_layer;
 static BitmapLayer *mask_layer;
 #endif
 
-static PropertyAnimation *work_animation;
-static PropertyAnimation *relax_animation;
-
 static TextLayer *clock_layer;
-static TextLayer *relax_minute_layer;
-static TextLayer *relax_second_layer;
+// Each holds the int it shows as layer data
+static Layer *relax_minute_layer;
+static Layer *relax_second_layer;
 static Layer *scale_layer;
 
-static GFont time_font;
-static GFont scale_font;
 
+// Held from the resource cache only while the layer showing them is on screen
 static GBitmap *pomodoro_image;
 static GBitmap *break_image;
+static bool is_pomodoro_shown;
 #ifdef PBL_COLOR
 static GBitmap *mask_image;
+// Color, artwork and mask composited once, while it exists the mask layer
+// is hidden and only the scale band needs the mask put back
+static GBitmap *background_image;
+static BandClip band_clips[SCALE_HEIGHT];
+static AppTimer *background_timer;
 #endif
 
 static int exec_state = RUNNING_EXEC_STATE;
+// Frozen remainder of the period while paused, end_time is stale then
+static int paused_remaining = -1;
 
-static TomatoSettings settings;
+static TomatoSettings *settings;
   
 static int increment_time = INCREMENT_TIME;
 
@@ -40,41 +63,115 @@ static bool is_animating;
 
 static int max_time = 59 * 60;
 
+// Last rendered values, the layers are only marked dirty when these change
+static int scale_offset = -1;
+static int relax_minute = -1;
+static int relax_second = -1;
+
+static bool is_low_power = false;
+static AppTimer *idle_timer;
+static AppTimer *exit_timer;
+// Armed for the next transition or visible change, whichever comes first
+static AppTimer *event_timer;
+
 static struct tm now;
 
-static int passed_time() {
-  return time(NULL) - settings.last_time;
-}
+// Cleared while a notification or other modal covers the app, nothing is drawn then
+static bool is_focused = true;
 
+// Read-only, it is called from the draw procs
 time_t get_diff() {
   int animate_shift = animate_time_factor * (ANIMATION_NORMALIZED_MAX - animate_time) / (ANIMATION_NORMALIZED_MAX - ANIMATION_NORMALIZED_MIN);
-  time_t diff = settings.current_duration - passed_time() - animate_shift;
+  time_t remaining = exec_state == PAUSED_EXEC_STATE ?
+    paused_remaining : settings->end_time - time(NULL);
+  time_t diff = remaining - animate_shift;
   if (diff < 0) {
     diff = 0;
   } else if (diff > max_time) {
-    settings.current_duration -= (diff - max_time);
     diff = max_time;
   }
+  if (is_low_power && !is_animating) {
+    // minute resolution: round up so the display never shows less time than is left
+    diff = (diff + 59) / 60 * 60;
+  }
   return diff;
 }
 
+// A paused session stays paused, it only gets the new remainder
+static void start_period(int duration) {
+  if (duration > max_time) {
+    duration = max_time;
+  }
+  if (exec_state == PAUSED_EXEC_STATE) {
+    paused_remaining = duration;
+    return;
+  }
+  settings->end_time = time(NULL) + duration;
+  deadline_queue_set(TIMER_MAIN, settings->end_time);
+}
+
+// Moves the deadline within [now, now + max_time], returns how far it actually moved
+static int adjust_end_time(int delta) {
+  if (exec_state == PAUSED_EXEC_STATE) {
+    int remaining = paused_remaining + delta;
+    remaining = remaining < 0 ? 0 : remaining > max_time ? max_time : remaining;
+    delta = remaining - paused_remaining;
+    paused_remaining = remaining;
+    checkpoint_save_later(paused_remaining);
+    return delta;
+  }
+  
+  time_t t = time(NULL);
+  int end_time = settings->end_time + delta;
+  if (end_time > t + max_time) {
+    end_time = t + max_time;
+  }
+  delta = end_time - settings->end_time;
+  settings->end_time = end_time;
+  deadline_queue_set(TIMER_MAIN, settings->end_time);
+  checkpoint_save_later(-1);
+  return delta;
+}
+
 const int sec_per_pixel = 60 / 8;
 const int half_max_ratio = TRIG_MAX_RATIO / 2;
 const int angle_90 = TRIG_MAX_ANGLE / 4;
 
+static const char *const scale_labels[] = {
+  "0", "5", "10", "15", "20", "25", "30", "35", "40", "45", "50", "55"
+};
+
+// Warped x of every linear x from -extra_x to width + extra_x
+static int16_t warp_table[SCALE_WIDTH + 2 * (SCALE_WIDTH / 4) + 1];
+
+static void build_warp_table(void) {
+  int width = SCALE_WIDTH;
+  int center = width / 2;
+  int extra_x = width / 4;
+  int pomodoro_width = center - 5;
+  int scale_x = center + extra_x;
+  long angle, round_factor, sin;
+  
+  for (int x = -extra_x; x <= width + extra_x; x++) {
+    angle = (x - center) * angle_90 / scale_x;
+    sin = sin_lookup(angle);
+    round_factor = sin < 0 ? -half_max_ratio : half_max_ratio;
+    warp_table[x + extra_x] = center + (sin * pomodoro_width + round_factor) / TRIG_MAX_RATIO;
+  }
+}
+
 static void layer_draw_scale(Layer *me, GContext* ctx) {
   GRect frame = layer_get_frame(me);
   int center = frame.size.w / 2;
   int extra_x = frame.size.w / 4;
-  int pomodoro_width = center - 5;
-  int scale_x = center + extra_x;
-  static char buffer[] = "00";
-  long angle, round_factor, sin;
   int mm, x;
   
+  PROFILE_BEGIN(PROFILE_DRAW_SCALE);
+  static TickMark marks[60 + 2 * SCALE_MARGIN_MINUTES];
+  int mark_count = 0;
   time_t diff = get_diff();
   int start = center - diff / sec_per_pixel;
-  int offset = 10;
+  int offset = SCALE_MARGIN_MINUTES;
   for (int m = -offset; m < 60 + offset; m++) {
     x = start + m * 60 / sec_per_pixel;
     bool is_on_edge = x < extra_x / 2 || x > frame.size.w - extra_x / 2;
@@ -88,201 +185,587 @@ static void layer_draw_scale(Layer *me, GContext* ctx) {
     if (mm < 0) {
       mm += 60;
     }
-    x -= center;
-    angle = x * angle_90 / scale_x;
-    sin = sin_lookup(angle);
-    round_factor = sin < 0 ? -half_max_ratio : half_max_ratio;
-    x = center + (sin_lookup(angle) * pomodoro_width + round_factor) / TRIG_MAX_RATIO;
-    graphics_context_set_stroke_color(ctx, PBL_IF_COLOR_ELSE(is_on_edge ? GColorLightGray : GColorWhite, GColorBlack));
+    x = warp_table[x + extra_x];
     if (mm % 5 == 0) {
-      graphics_context_set_text_color(ctx, PBL_IF_COLOR_ELSE(is_on_edge ? GColorLightGray : GColorWhite, GColorBlack));
-      snprintf(buffer, sizeof("00"), "%0d", mm);
       if (!is_text_on_edge) {
-        graphics_draw_text(ctx, buffer, scale_font, GRect(x - 15, 0, 30, 24), GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+        glyph_atlas_draw_text(ctx, scale_labels[mm / 5], GRect(x - 15, 0, 30, 24),
+                              is_on_edge ? TICK_FADED_COLOR : TICK_COLOR);
+        PROFILE_COUNT(PROFILE_DRAW_OPS, 1);
       }
-      graphics_draw_rect(ctx, GRect(x - 1, 27, 2, 8));
-    } else if (mm < settings.pomodoro_duration) {
-      graphics_draw_rect(ctx, GRect(x - 1, 32, 2, 3));
+      marks[mark_count++] = (TickMark) { .x = x - 1, .top = 27, .is_faded = is_on_edge };
+    } else if (mm < settings->pomodoro_duration) {
+      marks[mark_count++] = (TickMark) { .x = x - 1, .top = 32, .is_faded = is_on_edge };
     }
   }
+  // all marks go out through one frame buffer capture
+  tick_marks_draw(ctx, me, marks, mark_count);
+  PROFILE_COUNT(PROFILE_DRAW_OPS, mark_count);
+  #ifdef PBL_COLOR
+  if (background_image) {
+    background_restore_band(ctx, background_image, layer_convert_point_to_screen(me, GPointZero), frame, band_clips);
+  }
+  #endif
+  PROFILE_END(PROFILE_DRAW_SCALE);
+}
+
+static void layer_draw_countdown(Layer *me, GContext *ctx) {
+  PROFILE_BEGIN(PROFILE_DRAW_COUNTDOWN);
+  char buffer[] = "00";
+  GRect bounds = layer_get_bounds(me);
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+  snprintf(buffer, sizeof(buffer), "%02d", *(int *) layer_get_data(me));
+  glyph_atlas_draw_text(ctx, buffer, bounds, GColorWhite);
+  PROFILE_END(PROFILE_DRAW_COUNTDOWN);
+}
+
+// Launch is staged: the first frame needs only the artwork of the current
+// state, everything else is set up once that frame is on screen
+static uint32_t launch_ms;
+static bool is_launched;
+static AppTimer *launch_timer;
+
+static uint32_t uptime_ms(void) {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  return (uint32_t) seconds * 1000 + ms;
+}
+
+static void schedule_background(void);
+
+static void finish_launch(void *data) {
+  launch_timer = NULL;
+  is_launched = true;
+  uint32_t first_frame_ms = uptime_ms() - launch_ms;
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "First frame after %lu ms", (unsigned long) first_frame_ms);
+  PROFILE_VALUE(PROFILE_LAUNCH, first_frame_ms);
+  
+  history_sync_init();
+  schedule_background();
+}
+
+// The root layer draws first, so the atlas is rendered here before any layer needs it
+static void layer_draw_background(Layer *me, GContext *ctx) {
+  GRect bounds = layer_get_bounds(me);
+  if (is_launched) {
+    glyph_atlas_render(ctx, GPoint((bounds.size.w - GLYPH_ATLAS_WIDTH) / 2, (bounds.size.h - GLYPH_ATLAS_HEIGHT) / 2));
+  } else if (!launch_timer) {
+    // runs once the frame being drawn now has been flushed
+    launch_timer = app_timer_register(0, finish_launch, NULL);
+  }
+  graphics_context_set_fill_color(ctx, BACKGROUND_COLOR);
+  graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+}
+
+// The mask only covers the pomodoro artwork, so it comes and goes with it.
+// Both are blended on every frame until schedule_background() composites them.
+static void show_pomodoro_image(void) {
+  pomodoro_image = acquire_bitmap(RESOURCE_ID_IMAGE_WORK);
+  #ifdef PBL_COLOR
+  mask_image = acquire_bitmap(RESOURCE_ID_IMAGE_MASK);
+  bitmap_layer_set_compositing_mode(work_layer, GCompOpSet);
+  bitmap_layer_set_bitmap(mask_layer, mask_image);
+  layer_set_hidden(bitmap_layer_get_layer(mask_layer), false);
+  #endif
+  bitmap_layer_set_bitmap(work_layer, pomodoro_image);
+}
+
+static void hide_pomodoro_image(void) {
+  bitmap_layer_set_bitmap(work_layer, NULL);
+  if (pomodoro_image) {
+    pomodoro_image = NULL;
+    release_bitmap(RESOURCE_ID_IMAGE_WORK);
+  }
+  #ifdef PBL_COLOR
+  if (background_timer) {
+    app_timer_cancel(background_timer);
+    background_timer = NULL;
+  }
+  if (background_image) {
+    gbitmap_destroy(background_image);
+    background_image = NULL;
+  }
+  if (mask_image) {
+    bitmap_layer_set_bitmap(mask_layer, NULL);
+    mask_image = NULL;
+    release_bitmap(RESOURCE_ID_IMAGE_MASK);
+  }
+  #endif
+}
+
+static void hold_state_images(bool pomodoro_visible, bool break_visible) {
+  if (pomodoro_visible && !is_pomodoro_shown) {
+    show_pomodoro_image();
+  } else if (!pomodoro_visible && is_pomodoro_shown) {
+    hide_pomodoro_image();
+  }
+  is_pomodoro_shown = pomodoro_visible;
+  
+  if (break_visible && !break_image) {
+    break_image = acquire_bitmap(RESOURCE_ID_IMAGE_RELAX);
+    bitmap_layer_set_bitmap(relax_layer, break_image);
+  } else if (!break_visible && break_image) {
+    bitmap_layer_set_bitmap(relax_layer, NULL);
+    break_image = NULL;
+    release_bitmap(RESOURCE_ID_IMAGE_RELAX);
+  }
+}
+
+// Both artwork layers slide together, the relax layer sits one screen right of the work layer
+static Animation *switch_animation;
+static AnimationImplementation switch_animation_implementation;
+static int switch_from_x;
+static int switch_to_x;
+
+static void on_switch_screen_animation_update(Animation *anim, AnimationProgress progress) {
+  GRect frame = layer_get_frame(bitmap_layer_get_layer(work_layer));
+  frame.origin.x = switch_from_x + (switch_to_x - switch_from_x) * (int32_t) progress / ANIMATION_NORMALIZED_MAX;
+  layer_set_frame(bitmap_layer_get_layer(work_layer), frame);
+  frame.origin.x += frame.size.w;
+  layer_set_frame(bitmap_layer_get_layer(relax_layer), frame);
+}
+
+#ifdef PBL_COLOR
+static void build_background(void *data) {
+  background_timer = NULL;
+  // a slide that started meanwhile schedules it again once it stops
+  if (!pomodoro_image || !mask_image || switch_animation) {
+    return;
+  }
+  GSize size = layer_get_bounds(window_get_root_layer(window)).size;
+  background_image = background_create(size, BACKGROUND_COLOR, pomodoro_image, mask_image,
+                                       layer_get_frame(scale_layer), band_clips);
+  if (!background_image) {
+    // no heap for the composite or a mask it cannot clip, the layers keep blending on every frame
+    return;
+  }
+  // the sources stay in the resource cache only while the heap can spare them
+  pomodoro_image = NULL;
+  release_bitmap(RESOURCE_ID_IMAGE_WORK);
+  mask_image = NULL;
+  release_bitmap(RESOURCE_ID_IMAGE_MASK);
+  bitmap_layer_set_compositing_mode(work_layer, GCompOpAssign);
+  bitmap_layer_set_bitmap(work_layer, background_image);
+  bitmap_layer_set_bitmap(mask_layer, NULL);
+  layer_set_hidden(bitmap_layer_get_layer(mask_layer), true);
+}
+#endif
+
+// Composites the pomodoro background once the frame being drawn now is on
+// screen, never while launching or sliding, as that frame would be late
+static void schedule_background(void) {
+  #ifdef PBL_COLOR
+  if (is_launched && !switch_animation && is_pomodoro_shown && !background_image && !background_timer) {
+    background_timer = app_timer_register(0, build_background, NULL);
+  }
+  #endif
 }
 
 void on_switch_screen_animation_stopped(Animation *anim, bool finished, void *context) {
-  property_animation_destroy((PropertyAnimation*) anim);
+  animation_destroy(anim);
+  switch_animation = NULL;
+  hold_state_images(settings->state == POMODORO_STATE, settings->state == BREAK_STATE);
+  schedule_background();
 }
 
 static void fire_switch_screen_animation(bool relax_to_work) {
+  hold_state_images(true, true);
+  
   GRect from_frame = layer_get_frame(bitmap_layer_get_layer(work_layer));
-  GRect to_frame = relax_to_work ? 
-    (GRect) { .origin = { 0, 0 }, .size = from_frame.size } :
-    (GRect) { .origin = { -from_frame.size.w, 0 }, .size = from_frame.size };
-
-  work_animation = property_animation_create_layer_frame(bitmap_layer_get_layer(work_layer), &from_frame, &to_frame);
-  animation_set_handlers((Animation*) work_animation, (AnimationHandlers) {
+  switch_from_x = from_frame.origin.x;
+  switch_to_x = relax_to_work ? 0 : -from_frame.size.w;
+  
+  if (switch_animation) {
+    // a switch back during the slide turns the running animation around
+    animation_set_elapsed(switch_animation, 0);
+    PROFILE_HEAP();
+    return;
+  }
+  
+  switch_animation = animation_create();
+  switch_animation_implementation = (AnimationImplementation) {
+    .update = (AnimationUpdateImplementation) on_switch_screen_animation_update
+  };
+  animation_set_implementation(switch_animation, &switch_animation_implementation);
+  animation_set_handlers(switch_animation, (AnimationHandlers) {
     .stopped = (AnimationStoppedHandler) on_switch_screen_animation_stopped
   }, NULL);
-  animation_schedule((Animation*) work_animation);
+  animation_schedule(switch_animation);
+  PROFILE_HEAP();
+}
 
-  from_frame = layer_get_frame(bitmap_layer_get_layer(relax_layer));
-  to_frame = relax_to_work ? 
-    (GRect) { .origin = { from_frame.size.w, 0 }, .size = from_frame.size } :
-    (GRect) { .origin = { 0, 0 }, .size = from_frame.size };
+// Puts both artwork layers where the current state shows them, without animating
+static void place_state_layers() {
+  GRect frame = layer_get_frame(bitmap_layer_get_layer(work_layer));
+  if (settings->state == BREAK_STATE) {
+    layer_set_frame(bitmap_layer_get_layer(work_layer), (GRect) {.origin = { -frame.size.w, 0}, .size = frame.size });
+    layer_set_frame(bitmap_layer_get_layer(relax_layer), (GRect) {.origin = { 0, 0}, .size = frame.size });
+  } else {
+    layer_set_frame(bitmap_layer_get_layer(work_layer), (GRect) {.origin = { 0, 0}, .size = frame.size });
+    layer_set_frame(bitmap_layer_get_layer(relax_layer), (GRect) {.origin = { frame.size.w, 0}, .size = frame.size });
+  }
+  hold_state_images(settings->state == POMODORO_STATE, settings->state == BREAK_STATE);
+}
 
-  relax_animation = property_animation_create_layer_frame(bitmap_layer_get_layer(relax_layer), &from_frame, &to_frame);
-  animation_set_handlers((Animation*) relax_animation, (AnimationHandlers) {
-    .stopped = (AnimationStoppedHandler) on_switch_screen_animation_stopped
-  }, NULL);
-  animation_schedule((Animation*) relax_animation);
+void invalidate_time() {
+  scale_offset = -1;
+  relax_minute = -1;
+  relax_second = -1;
 }
 
 void toggle_pomodoro_relax(int skip) {
-  if (settings.state == POMODORO_STATE) {
-    if (!skip) {
-      settings.calendar.sets[0]++;
+  invalidate_time();
+  if (settings->state == POMODORO_STATE) {
+    time_t t = time(NULL);
+    if (skip) {
+      history_add_skipped(t);
+    } else {
+      history_add_completed(t);
+    }
+    int completed = history_get_day(t).completed;
+    settings->state = BREAK_STATE;
+    if (settings->long_break_enabled &&
+        completed > 0 && ((completed - 1) % settings->long_break_delay) == settings->long_break_delay - 1) {
+      start_period(settings->long_break_duration * 60);
+      history_add_long_break(t);
+    } else {
+      start_period(settings->break_duration * 60);
     }
-    settings.state = BREAK_STATE;
-    settings.current_duration = (
-      settings.long_break_enabled &&
-      ((settings.calendar.sets[0] - 1) % settings.long_break_delay) == settings.long_break_delay - 1) ?
-        settings.long_break_duration * 60 :
-        settings.break_duration * 60;
     vibes_short_pulse();
-    fire_switch_screen_animation(false);
+    if (is_focused) {
+      fire_switch_screen_animation(false);
+    }
   } else {
-    settings.state = POMODORO_STATE;
-    settings.current_duration = settings.pomodoro_duration * 60;
+    settings->state = POMODORO_STATE;
+    start_period(settings->pomodoro_duration * 60);
     vibes_double_pulse();
-    fire_switch_screen_animation(true);
+    if (is_focused) {
+      fire_switch_screen_animation(true);
+    }
   }
+  checkpoint_save(paused_remaining);
 }
 
 void update_clock() {
   static char buffer[] = "00:00";
+  if (exec_state == PAUSED_EXEC_STATE) {
+    text_layer_set_text(clock_layer, "Paused");
+    return;
+  }
   strftime(buffer, sizeof("00:00"), "%H:%M", &now);
   text_layer_set_text(clock_layer, buffer);
 }
 
 void update_relax_minute() {
-  static char buffer[] = "00";
-  time_t diff = get_diff();
-  strftime(buffer, sizeof("00"), "%M", localtime(&diff));
-  text_layer_set_text(relax_minute_layer, buffer);
+  int minute = get_diff() / 60 % 60;
+  if (minute == relax_minute) {
+    return;
+  }
+  relax_minute = minute;
+  PROFILE_COUNT(PROFILE_REDRAWS, 1);
+  *(int *) layer_get_data(relax_minute_layer) = minute;
+  layer_mark_dirty(relax_minute_layer);
 }
 
 void update_relax_second() {
-  static char buffer[] = "00";
-  time_t diff = get_diff();
-  strftime(buffer, sizeof("00"), "%S", localtime(&diff));
-  text_layer_set_text(relax_second_layer, buffer);
+  int second = get_diff() % 60;
+  if (second == relax_second) {
+    return;
+  }
+  relax_second = second;
+  PROFILE_COUNT(PROFILE_REDRAWS, 1);
+  *(int *) layer_get_data(relax_second_layer) = second;
+  layer_mark_dirty(relax_second_layer);
+}
+
+void update_scale() {
+  int offset = get_diff() / sec_per_pixel;
+  if (offset == scale_offset) {
+    return;
+  }
+  scale_offset = offset;
+  PROFILE_COUNT(PROFILE_REDRAWS, 1);
+  layer_mark_dirty(scale_layer);
 }
 
 void on_scale_animation_update(Animation* animation, uint32_t distance_normalized) {
   animate_time = distance_normalized;
+  PROFILE_COUNT(PROFILE_REDRAWS, 1);
   layer_mark_dirty(scale_layer);
 }
 
-void on_scale_animation_started(Animation* animation, void *data) {
-  is_animating = true;
-}
+static Animation *scale_animation;
+static AnimationImplementation scale_animation_implementation;
 
 void on_scale_animation_stopped(Animation* animation, bool finished, void *data) {
   is_animating = false;
   animate_time = 0;
   animate_time_factor = 0;
-  layer_mark_dirty(scale_layer);
+  scale_offset = -1;
+  update_scale();
   animation_destroy(animation);
+  scale_animation = NULL;
 }
 
-static Animation *animation;
-static AnimationImplementation animation_implementation;
+// Slides the scale over the last delta seconds. Clicks during the slide fold
+// what is left of it into the same animation, which restarts towards the sum.
+void animate_scale(int delta) {
+  int animate_shift = animate_time_factor * (ANIMATION_NORMALIZED_MAX - animate_time) / (ANIMATION_NORMALIZED_MAX - ANIMATION_NORMALIZED_MIN);
+  animate_time_factor = animate_shift + delta;
+  animate_time = 0;
+  is_animating = true;
   
-void animate_scale() {
-  animation = animation_create();
-  animation_set_duration(animation, 300);
+  if (scale_animation) {
+    animation_set_elapsed(scale_animation, 0);
+    return;
+  }
   
-  animation_implementation = (AnimationImplementation) {
+  scale_animation = animation_create();
+  animation_set_duration(scale_animation, 300);
+  
+  scale_animation_implementation = (AnimationImplementation) {
     .update = (AnimationUpdateImplementation) on_scale_animation_update
   };
 
-  animation_set_implementation(animation, &animation_implementation);
-  animation_set_handlers(animation, (AnimationHandlers) {
-    .stopped = (AnimationStoppedHandler) on_scale_animation_stopped,
-    .started = (AnimationStartedHandler) on_scale_animation_started
+  animation_set_implementation(scale_animation, &scale_animation_implementation);
+  animation_set_handlers(scale_animation, (AnimationHandlers) {
+    .stopped = (AnimationStoppedHandler) on_scale_animation_stopped
   }, NULL);
-  animation_schedule(animation);
+  animation_schedule(scale_animation);
 }
 
-void update_time(bool animate) {
-  if (settings.state == BREAK_STATE) {
-    animate_time_factor = 0;
+void update_time() {
+  if (!is_focused) {
+    return;
+  }
+  if (settings->state == BREAK_STATE) {
     update_relax_minute();
     update_relax_second();
-  } else if (animate) {
-    animate_scale();
+  } else if (!is_animating) {
+    update_scale();
+  }
+}
+
+// When the displayed value next changes: every second on the break screen,
+// every sec_per_pixel seconds on the scale and every minute in low-power mode
+static time_t next_visible_change(time_t t) {
+  int diff = settings->end_time - t;
+  if (diff > max_time) {
+    diff = max_time;
+  }
+  if (diff <= 0) {
+    return settings->end_time;
+  }
+  if (is_low_power) {
+    return t + diff - (diff - 1) / 60 * 60;
+  } else if (settings->state == BREAK_STATE) {
+    return t + 1;
   } else {
-    animate_time_factor = 0;
-    layer_mark_dirty(scale_layer);
+    return t + diff - diff / sec_per_pixel * sec_per_pixel + 1;
+  }
+}
+
+static void event_callback(void *data);
+
+static void schedule_next_event() {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  
+  // one timer serves every queued deadline and the display, a paused or
+  // covered display needs no updates
+  uint8_t id;
+  time_t next_time;
+  bool is_due = deadline_queue_peek(&id, &next_time);
+  if (exec_state == RUNNING_EXEC_STATE && is_focused) {
+    time_t change_time = next_visible_change(seconds);
+    if (!is_due || change_time < next_time) {
+      next_time = change_time;
+    }
+    is_due = true;
+  }
+  if (!is_due) {
+    if (event_timer) {
+      app_timer_cancel(event_timer);
+      event_timer = NULL;
+    }
+    return;
+  }
+  
+  int32_t delay = (next_time - seconds) * 1000 - ms;
+  if (delay < 0) {
+    delay = 0;
+  }
+  if (!event_timer || !app_timer_reschedule(event_timer, delay)) {
+    event_timer = app_timer_register(delay, event_callback, NULL);
+  }
+}
+
+static void event_callback(void *data) {
+  event_timer = NULL;
+  PROFILE_COUNT(PROFILE_WAKEUPS, 1);
+  time_t t = time(NULL);
+  uint8_t id;
+  time_t deadline;
+  while (deadline_queue_peek(&id, &deadline) && deadline <= t) {
+    deadline_queue_remove(id);
+    if (id != TIMER_MAIN) {
+      timers_fire(id, t);
+    } else if (exec_state == RUNNING_EXEC_STATE) {
+      toggle_pomodoro_relax(false);
+    }
+  }
+  update_time();
+  schedule_next_event();
+}
+
+static void enter_low_power(void *data) {
+  idle_timer = NULL;
+  PROFILE_COUNT(PROFILE_WAKEUPS, 1);
+  is_low_power = true;
+  update_time();
+  schedule_next_event();
+}
+
+static void leave_low_power() {
+  is_low_power = false;
+  update_time();
+  schedule_next_event();
+}
+
+static void exit_callback(void *data) {
+  exit_timer = NULL;
+  // the deadline is handed off to the Wakeup API in deinit()
+  window_stack_pop_all(false);
+}
+
+static void register_input() {
+  if (!idle_timer || !app_timer_reschedule(idle_timer, LOW_POWER_IDLE * 1000)) {
+    idle_timer = app_timer_register(LOW_POWER_IDLE * 1000, enter_low_power, NULL);
+  }
+  if (!exit_timer || !app_timer_reschedule(exit_timer, APP_EXIT_IDLE * 1000)) {
+    exit_timer = app_timer_register(APP_EXIT_IDLE * 1000, exit_callback, NULL);
+  }
+  if (is_low_power) {
+    leave_low_power();
   }
 }
 
 void up_longclick_handler(ClickRecognizerRef recognizer, void *context) {
-  settings.last_time = time(NULL);
+  register_input();
   toggle_pomodoro_relax(true);
   
-  update_time(false);
+  update_time();
+  schedule_next_event();
 }
 
 void down_click_handler(ClickRecognizerRef recognizer, void *context) {
-  settings.current_duration += increment_time;
-  if (settings.state == POMODORO_STATE) {
-    animate_time_factor = increment_time;
+  register_input();
+  int delta = adjust_end_time(increment_time);
+  if (settings->state == POMODORO_STATE) {
+    animate_scale(delta);
+  } else {
+    update_time();
   }
-  update_time(true);
+  schedule_next_event();
 }
 
 void up_click_handler(ClickRecognizerRef recognizer, void *context) {
-  settings.current_duration -= increment_time;
-  if (settings.state == POMODORO_STATE) {
-    animate_time_factor = -increment_time;  
+  register_input();
+  int delta = adjust_end_time(-increment_time);
+  if (settings->state == POMODORO_STATE) {
+    animate_scale(delta);
+  } else {
+    update_time();
   }
-  update_time(true);
+  schedule_next_event();
 }
 
 void select_longclick_handler(ClickRecognizerRef recognizer, void *context) {
+  register_input();
   show_menu();
 }
 
 void select_click_handler(ClickRecognizerRef recognizer, void *context) {
+  register_input();
   show_iteration();
 }
 
+static void handle_tick(struct tm *tick_time, TimeUnits units_changed);
+
+// Freezes the remainder and drops every wakeup the session caused: its
+// deadline, the display timer and the clock ticks
+static void pause_session(void) {
+  int remaining = settings->end_time - time(NULL);
+  paused_remaining = remaining < 0 ? 0 : remaining;
+  exec_state = PAUSED_EXEC_STATE;
+  deadline_queue_remove(TIMER_MAIN);
+  tick_timer_service_unsubscribe();
+  checkpoint_save(paused_remaining);
+}
+
+static void resume_session(void) {
+  exec_state = RUNNING_EXEC_STATE;
+  settings->end_time = time(NULL) + paused_remaining;
+  paused_remaining = -1;
+  deadline_queue_set(TIMER_MAIN, settings->end_time);
+  tick_timer_service_subscribe(MINUTE_UNIT, handle_tick);
+  time_t t = time(NULL);
+  now = *localtime(&t);
+  checkpoint_save(paused_remaining);
+}
+
+void down_longclick_handler(ClickRecognizerRef recognizer, void *context) {
+  register_input();
+  if (exec_state == RUNNING_EXEC_STATE) {
+    pause_session();
+  } else {
+    resume_session();
+  }
+  vibes_short_pulse();
+  update_clock();
+  invalidate_time();
+  update_time();
+  schedule_next_event();
+}
+
+// Only the clock needs the tick service, the timer itself runs on event_timer
 static void handle_tick(struct tm *tick_time, TimeUnits units_changed) {
+  PROFILE_BEGIN(PROFILE_TICK);
+  PROFILE_COUNT(PROFILE_WAKEUPS, 1);
+  // ticks are due on the minute, the milliseconds past it are the delivery latency
+  PROFILE_VALUE(PROFILE_TICK_LATENCY, time_ms(NULL, NULL));
   now = *tick_time;
-  if (units_changed & MINUTE_UNIT) {
+  if (is_focused) {
     update_clock();
   }
+  PROFILE_END(PROFILE_TICK);
+}
 
-  if (exec_state != RUNNING_EXEC_STATE) {
-    return;
-  }
-  
-  if (is_animating) {
-    return;
+// Losing focus drops the display timer, only queued deadlines keep waking the app
+static void will_focus_handler(bool in_focus) {
+  if (!in_focus) {
+    is_focused = false;
+    schedule_next_event();
   }
+}
 
-  if(passed_time() > settings.current_duration) {
-    settings.last_time = time(NULL);
-    toggle_pomodoro_relax(false);
+// One catch-up redraw once the covering modal is gone
+static void did_focus_handler(bool in_focus) {
+  if (!in_focus || is_focused) {
+    return;
   }
-  
-  if (units_changed & SECOND_UNIT) {
-    if (settings.state == BREAK_STATE) {
-      update_relax_minute();
-      update_relax_second();
-    } else {
-      update_time(false);
-    }
+  is_focused = true;
+  if (!switch_animation) {
+    place_state_layers();
   }
+  time_t t = time(NULL);
+  now = *localtime(&t);
+  update_clock();
+  invalidate_time();
+  update_time();
+  schedule_next_event();
 }
 
 void config_provider(void *context) {
@@ -293,6 +776,7 @@ void config_provider(void *context) {
   window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
   
   window_long_click_subscribe(BUTTON_ID_UP, 300, up_longclick_handler, NULL);
+  window_long_click_subscribe(BUTTON_ID_DOWN, 300, down_longclick_handler, NULL);
 }
 
 static void window_load(Window *window) {
@@ -306,52 +790,42 @@ static void window_load(Window *window) {
   int center_x = window_width / 2;
   int center_y = window_height / 2;
   
+  layer_set_update_proc(window_layer, layer_draw_background);
+  
   work_layer = bitmap_layer_create(bounds);
-  bitmap_layer_set_bitmap(work_layer, pomodoro_image);
-  #ifdef PBL_COLOR
-  bitmap_layer_set_compositing_mode(work_layer, GCompOpSet);
-  #endif
   layer_add_child(window_layer, bitmap_layer_get_layer(work_layer));
   
   bounds = (GRect) { .origin = { window_width, 0 }, .size = bounds.size };
   relax_layer = bitmap_layer_create(bounds);
-  bitmap_layer_set_bitmap(relax_layer, break_image);
   #ifdef PBL_COLOR
   bitmap_layer_set_compositing_mode(relax_layer, GCompOpSet);
   #endif
   layer_add_child(window_layer, bitmap_layer_get_layer(relax_layer));
 
-  time_font = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_DD_24));
-  scale_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+  // labels and the countdown are blitted from an atlas of this font after launch
+  glyph_atlas_init(fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
   GFont clock_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
-  GFont relax_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
   
-  bounds = (GRect) { .origin = { center_x - 70, center_y - 29 }, .size = { 140, 35 } };
+  bounds = (GRect) { .origin = { center_x - SCALE_WIDTH / 2, center_y - 29 }, .size = { SCALE_WIDTH, SCALE_HEIGHT } };
+  build_warp_table();
   scale_layer = layer_create(bounds);
   layer_set_update_proc(scale_layer, layer_draw_scale);
   layer_add_child(bitmap_layer_get_layer(work_layer), scale_layer);
   
   bounds = (GRect) { .origin = { center_x - 47, center_y - 21 }, .size = { 24, 24 } };
-  relax_minute_layer = text_layer_create(bounds);
-  text_layer_set_text_alignment(relax_minute_layer, GTextAlignmentCenter);
-  text_layer_set_font(relax_minute_layer, relax_font);
-  text_layer_set_background_color(relax_minute_layer, GColorBlack);
-  text_layer_set_text_color(relax_minute_layer, GColorWhite);
-  layer_add_child(bitmap_layer_get_layer(relax_layer), text_layer_get_layer(relax_minute_layer));
+  relax_minute_layer = layer_create_with_data(bounds, sizeof(int));
+  layer_set_update_proc(relax_minute_layer, layer_draw_countdown);
+  layer_add_child(bitmap_layer_get_layer(relax_layer), relax_minute_layer);
   
   bounds = (GRect) { .origin = { center_x + 20, center_y - 21 }, .size = { 24, 24 } };
-  relax_second_layer = text_layer_create(bounds);
-  text_layer_set_text_alignment(relax_second_layer, GTextAlignmentCenter);
-  text_layer_set_font(relax_second_layer, relax_font);
-  text_layer_set_background_color(relax_second_layer, GColorBlack);
-  text_layer_set_text_color(relax_second_layer, GColorWhite);
-  layer_add_child(bitmap_layer_get_layer(relax_layer), text_layer_get_layer(relax_second_layer));
+  relax_second_layer = layer_create_with_data(bounds, sizeof(int));
+  layer_set_update_proc(relax_second_layer, layer_draw_countdown);
+  layer_add_child(bitmap_layer_get_layer(relax_layer), relax_second_layer);
   
   const int clock_height = 24;
 
   #ifdef PBL_COLOR
   mask_layer = bitmap_layer_create(window_bounds);
-  bitmap_layer_set_bitmap(mask_layer, mask_image);
   bitmap_layer_set_compositing_mode(mask_layer, GCompOpSet);
   layer_add_child(bitmap_layer_get_layer(work_layer), bitmap_layer_get_layer(mask_layer));
   #endif
@@ -366,49 +840,72 @@ static void window_load(Window *window) {
 }
 
 static void window_unload(Window *window) {
+  hold_state_images(false, false);
   bitmap_layer_destroy(work_layer);
   bitmap_layer_destroy(relax_layer);
   #ifdef PBL_COLOR
   bitmap_layer_destroy(mask_layer);
   #endif
   text_layer_destroy(clock_layer);
-  text_layer_destroy(relax_second_layer);
-  text_layer_destroy(relax_minute_layer);
-  fonts_unload_custom_font(time_font);
+  layer_destroy(relax_second_layer);
+  layer_destroy(relax_minute_layer);
+  glyph_atlas_destroy();
 }
 
 static void window_appear(Window *window) {
-  settings = read_settings();
-  
-  if (settings.state == BREAK_STATE) {
-    GRect frame = layer_get_frame(bitmap_layer_get_layer(work_layer));
-    layer_set_frame(bitmap_layer_get_layer(work_layer), (GRect) {.origin = { -frame.size.w, 0}, .size = frame.size });
-    layer_set_frame(bitmap_layer_get_layer(relax_layer), (GRect) {.origin = { 0, 0}, .size = frame.size });
+  if (take_settings_reset() && exec_state == PAUSED_EXEC_STATE) {
+    // the reset session starts running, the checkpoint below forgets the pause
+    exec_state = RUNNING_EXEC_STATE;
+    paused_remaining = -1;
+    tick_timer_service_subscribe(MINUTE_UNIT, handle_tick);
+  }
+  // settings may have been reset from the menu, so both frames are placed for the current state
+  place_state_layers();
+  if (exec_state == RUNNING_EXEC_STATE) {
+    deadline_queue_set(TIMER_MAIN, settings->end_time);
   }
+  checkpoint_save(paused_remaining);
 
   time_t t = time(NULL);
   now = *localtime(&t);
   update_clock();
 
+  invalidate_time();
   update_relax_minute();
   update_relax_second();
-  layer_mark_dirty(scale_layer);
+  update_scale();
+  schedule_next_event();
+  schedule_background();
+  // closes the probe opened in init, returning from a child window finds it closed
+  PROFILE_END(PROFILE_WINDOW);
 }
 
 static void window_disappear(Window *window) {
-  save_settings(settings);
+  save_settings();
+  save_history();
+  save_timers();
 }
 
 static void init(void) {
+  launch_ms = uptime_ms();
+  PROFILE_INIT();
+  PROFILE_BEGIN(PROFILE_WINDOW);
   time_t t = time(NULL);
   now = *localtime(&t);
   
-  pomodoro_image = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_WORK);
-  break_image = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_RELAX);  
-  #ifdef PBL_COLOR
-  mask_image = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_MASK);
-  #endif
-
+  load_settings();
+  load_history();
+  load_timers();
+  checkpoint_restore(&paused_remaining);
+  settings = get_settings();
+  bool is_handed_off = handoff_resume();
+  if (paused_remaining >= 0) {
+    // a paused session waits for resume however long the app was closed
+    exec_state = PAUSED_EXEC_STATE;
+  } else if (!is_handed_off) {
+    expire_session();
+  }
+  
   window = window_create();
   
   #ifndef PBL_SDK_3
@@ -425,25 +922,44 @@ static void init(void) {
   });
   
   const bool animated = true;
-  window_set_background_color(window, PBL_IF_COLOR_ELSE(GColorDukeBlue, GColorBlack));
+  window_set_background_color(window, BACKGROUND_COLOR);
   window_stack_push(window, animated);
   
-  tick_timer_service_subscribe(SECOND_UNIT, handle_tick);
+  if (exec_state == RUNNING_EXEC_STATE) {
+    tick_timer_service_subscribe(MINUTE_UNIT, handle_tick);
+  }
+  app_focus_service_subscribe_handlers((AppFocusHandlers) {
+    .will_focus = will_focus_handler,
+    .did_focus = did_focus_handler
+  });
+  register_input();
 }
 
 static void deinit(void) {
-  gbitmap_destroy(pomodoro_image);
-  gbitmap_destroy(break_image);
-  #ifdef PBL_COLOR
-  gbitmap_destroy(mask_image);
-  #endif
+  PROFILE_DUMP();
+  app_focus_service_unsubscribe();
+  checkpoint_save(paused_remaining);
+  save_settings();
+  save_history();
+  save_timers();
+  // the one wakeup slot goes to whichever queued timer is due first
+  uint8_t id;
+  time_t deadline;
+  if (deadline_queue_peek(&id, &deadline)) {
+    handoff_schedule(deadline);
+  }
+  history_sync_deinit();
 
+  menu_deinit();
+  iteration_deinit();
   window_destroy(window);
+  trim_resources(true);
 }
 
 int main(void) {
   init();
   app_event_loop();
   deinit();
+  return 0;
 }
 